@@ -0,0 +1,222 @@
+#ifndef __AFFOREST_H__
+#define __AFFOREST_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "graph_csr.h"
+#include "parallel_csr.h"
+#include "thread_pool.h"
+
+///
+/// @brief Per node component labels from a parallel components engine
+///
+/// labels[n] is the lowest numbered node in n's component, so two nodes are
+/// connected if and only if their labels match.
+///
+template< typename label_int_t >
+struct parallel_components_t {
+  std::vector< label_int_t > labels;
+  size_t num_components = 0;
+};
+
+namespace afforest_detail {
+
+template< typename label_int_t >
+using label_array_t = std::vector< std::atomic< label_int_t > >;
+
+/// Hook the trees containing node_a and node_b together.  The higher
+/// numbered root is always hooked under the lower one, so there are no
+/// cycles, and the compare exchange means racing hooks can't be lost.
+template< typename label_int_t >
+void link( label_int_t node_a, label_int_t node_b, label_array_t< label_int_t >& comp )
+{
+  label_int_t parent_a = comp[ node_a ].load( std::memory_order_relaxed );
+  label_int_t parent_b = comp[ node_b ].load( std::memory_order_relaxed );
+
+  while ( parent_a != parent_b ) {
+    const label_int_t high = std::max( parent_a, parent_b );
+    const label_int_t low = std::min( parent_a, parent_b );
+    label_int_t parent_high = comp[ high ].load( std::memory_order_relaxed );
+
+    // Already hooked to low, or we got high (a root) hooked to low
+    if ( parent_high == low ) {
+      break;
+    }
+    if ( parent_high == high
+      && comp[ high ].compare_exchange_strong( parent_high, low, std::memory_order_relaxed ) ) {
+      break;
+    }
+    parent_a = comp[ comp[ high ].load( std::memory_order_relaxed ) ].load( std::memory_order_relaxed );
+    parent_b = comp[ low ].load( std::memory_order_relaxed );
+  }
+}
+
+/// Point every node straight at its root
+template< typename label_int_t >
+void compress( label_array_t< label_int_t >& comp, thread_pool_t& pool )
+{
+  pool.parallel_for( 0, comp.size(), [ & ]( size_t first, size_t last ) {
+    for ( size_t node = first; node < last; ++node ) {
+      label_int_t parent = comp[ node ].load( std::memory_order_relaxed );
+      label_int_t grandparent = comp[ parent ].load( std::memory_order_relaxed );
+      while ( parent != grandparent ) {
+        comp[ node ].store( grandparent, std::memory_order_relaxed );
+        parent = grandparent;
+        grandparent = comp[ parent ].load( std::memory_order_relaxed );
+      }
+    }
+  });
+}
+
+/// Guess the largest component's label from a random sample of nodes
+template< typename label_int_t >
+label_int_t sample_frequent_label( const label_array_t< label_int_t >& comp, size_t num_samples = 1024 )
+{
+  std::unordered_map< label_int_t, size_t > counts;
+  std::mt19937 rng{ 27491095 };
+  std::uniform_int_distribution< size_t > pick{ 0, comp.size() - 1 };
+
+  for ( size_t sample = 0; sample < num_samples; ++sample ) {
+    ++counts[ comp[ pick( rng ) ].load( std::memory_order_relaxed ) ];
+  }
+
+  label_int_t most_frequent = 0;
+  size_t most_count = 0;
+  for ( const auto& [ label, count ] : counts ) {
+    if ( count > most_count ) {
+      most_frequent = label;
+      most_count = count;
+    }
+  }
+  return most_frequent;
+}
+
+}
+
+///
+/// @brief Parallel connected components (Afforest)
+///
+/// @param graph  A bi-directional CSR graph, i.e., from double_up_edges
+/// @param pool   Threads to run on
+/// @return       A label per node and the number of components
+///
+/// Afforest (Sutton et al., 2018) is a Shiloach-Vishkin style hook and
+/// compress algorithm that avoids looking at most edges:
+///
+/// 1. Link every node to its first few neighbors and compress.  On real
+///    graphs that's already most of the giant component.
+/// 2. Sample labels to guess which component is the giant one.
+/// 3. Link the rest of the neighbors, skipping nodes already in the giant
+///    component.  The graph is bi-directional, so any edge between the
+///    giant component and another node is still linked from the other
+///    node's side.
+/// 4. Compress again, so every label is a root.
+///
+template< typename csr_type >
+auto afforest_components( const csr_type& graph, thread_pool_t& pool, size_t neighbor_rounds = 2 )
+{
+  using label_int_t = typename csr_type::stored_node_id_t::int_type;
+  using namespace afforest_detail;
+
+  const size_t num_nodes = graph.get_num_nodes();
+  label_array_t< label_int_t > comp( num_nodes );
+
+  pool.parallel_for( 0, num_nodes, [ & ]( size_t first, size_t last ) {
+    for ( size_t node = first; node < last; ++node ) {
+      comp[ node ].store( static_cast< label_int_t >( node ), std::memory_order_relaxed );
+    }
+  });
+
+  // 1. Sample a few neighbors of every node
+  for ( size_t round = 0; round < neighbor_rounds; ++round ) {
+    pool.parallel_for( 0, num_nodes, [ & ]( size_t first, size_t last ) {
+      for ( size_t node = first; node < last; ++node ) {
+        const auto fanout = graph.neighbors( node_id_t{ node } );
+        if ( round < fanout.size() ) {
+          link< label_int_t >( node, fanout[ round ].value(), comp );
+        }
+      }
+    });
+    compress( comp, pool );
+  }
+
+  // 2. Find the (probable) giant component
+  const label_int_t giant = num_nodes > 0 ? sample_frequent_label( comp ) : 0;
+
+  // 3. Finish the nodes outside it
+  pool.parallel_for( 0, num_nodes, [ & ]( size_t first, size_t last ) {
+    for ( size_t node = first; node < last; ++node ) {
+      if ( comp[ node ].load( std::memory_order_relaxed ) == giant ) {
+        continue;
+      }
+      const auto fanout = graph.neighbors( node_id_t{ node } );
+      for ( size_t edge = neighbor_rounds; edge < fanout.size(); ++edge ) {
+        link< label_int_t >( node, fanout[ edge ].value(), comp );
+      }
+    }
+  });
+
+  // 4. Every label becomes a root.  Roots label themselves.
+  compress( comp, pool );
+
+  parallel_components_t< label_int_t > result;
+  result.labels.resize( num_nodes );
+  std::mutex roots_mutex;
+  pool.parallel_for( 0, num_nodes, [ & ]( size_t first, size_t last ) {
+    size_t roots = 0;
+    for ( size_t node = first; node < last; ++node ) {
+      const label_int_t label = comp[ node ].load( std::memory_order_relaxed );
+      result.labels[ node ] = label;
+      roots += ( label == node );
+    }
+    std::lock_guard lock{ roots_mutex };
+    result.num_components += roots;
+  });
+  return result;
+}
+
+///
+/// @brief double_up_edges for a CSR graph, on a thread pool
+///
+/// Each range of nodes adds its edges in both directions, and
+/// make_csr_parallel builds the bi-directional graph from them.
+///
+template< typename csr_type >
+runtime_csr_t double_up_edges_parallel( const csr_type& graph, thread_pool_t& pool )
+{
+  const size_t num_nodes = graph.get_num_nodes();
+  const size_t num_sources = pool.size() * 16;
+  const size_t source_size = num_nodes / num_sources + 1;
+
+  return make_csr_parallel< runtime_csr_t >( num_nodes, num_sources, [ & ]( size_t source, auto add_edge ) {
+    const size_t last = std::min( ( source + 1 ) * source_size, num_nodes );
+    for ( size_t node = std::min( source * source_size, num_nodes ); node < last; ++node ) {
+      for ( const node_id_t dst_node : graph.neighbors( node_id_t{ node } ) ) {
+        add_edge( node_id_t{ node }, dst_node );
+        add_edge( dst_node, node_id_t{ node } );
+      }
+    }
+  }, pool );
+}
+
+///
+/// @brief Count connected subgraphs with Afforest on a thread pool
+///
+/// The parallel counterpart of count_connected for CSR graphs.  The edges
+/// are doubled up on the pool as well, by double_up_edges_parallel.
+///
+template< typename csr_type >
+int count_connected_afforest( const csr_type& graph, thread_pool_t& pool )
+{
+  const auto bidir_graph = double_up_edges_parallel( graph, pool );
+  return static_cast< int >( afforest_components( bidir_graph, pool ).num_components );
+}
+
+#endif
+
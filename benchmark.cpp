@@ -0,0 +1,442 @@
+#include <string_view>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include "graph_raw.h"
+#include "graph_undirected.h"
+#include "bfs_components.h"
+#include "label_propagation.h"
+#include "connected.h"
+#include "union_find.h"
+#include "graph_csr.h"
+#include "afforest.h"
+#include "concurrent_union_find.h"
+#include "graph_generators.h"
+#include "node_reordering.h"
+#include "connectivity_query.h"
+#include "parallel_parsing.h"
+#include "edge_dedup.h"
+#include "csr_file.h"
+
+/// @brief Run time benchmarks of the parse, build and count phases.
+///
+/// Generates graphs of each shape in graph_generators.h, at sizes going up
+/// by 10x, and times every phase and engine on them separately.  Counts
+/// from the engines are checked against count_connected, so a benchmark
+/// run also catches engines that disagree.
+
+/// @brief Benchmark options, set from the command line
+struct benchmark_options_t {
+  /// Smallest graph, in edges
+  size_t min_edges = 1000;
+  /// Largest graph, in edges.  Sizes go up by 10x from min_edges.
+  size_t max_edges = 1000000;
+  /// Shapes to generate.  Empty means all of them.
+  std::vector< graph_shape_t > shapes;
+  /// Threads for the parallel engines
+  unsigned threads = 1;
+};
+
+/// @brief Reset the process's peak resident set size to what's resident
+///        now, so peak_rss_mb measures from here.  false if it can't be.
+///
+/// Writing 5 to clear_refs resets VmHWM.  Linux 4.0 and later.  Freed
+/// heap is given back first, or what earlier phases freed would count
+/// towards every later phase's peak.
+///
+bool reset_peak_rss()
+{
+  ::malloc_trim( 0 );
+  std::ofstream clear_refs{ "/proc/self/clear_refs" };
+  clear_refs << "5";
+  clear_refs.flush();
+  return static_cast< bool >( clear_refs );
+}
+
+/// @brief Gets the peak resident set size since reset_peak_rss, in MB
+///
+/// It includes whatever was resident before the phase too, i.e., the
+/// graph the phase runs on.  0 if VmHWM can't be read.
+///
+double peak_rss_mb()
+{
+  std::ifstream status{ "/proc/self/status" };
+  std::string line;
+  while ( std::getline( status, line ) ) {
+    if ( line.starts_with( "VmHWM:" ) ) {
+      // In kilobytes
+      return std::stod( line.substr( std::string_view{ "VmHWM:" }.size() ) ) / 1024.0;
+    }
+  }
+  return 0.0;
+}
+
+///
+/// @brief Run a phase and print a row of results
+///
+/// @param shape      The shape of graph the phase ran on
+/// @param num_edges  Edges in the graph, for the per edge numbers
+/// @param phase      Name of the phase
+/// @param func       The phase.  Its return value is passed through.
+///
+template< typename F >
+auto benchmark_phase( graph_shape_t shape, size_t num_edges, std::string_view phase, F func )
+{
+  using clock = std::chrono::steady_clock;
+  const bool rss_reset = reset_peak_rss();
+  const auto start = clock::now();
+  auto result = func();
+  const std::chrono::duration< double, std::nano > elapsed = clock::now() - start;
+
+  const double edges = static_cast< double >( std::max< size_t >( num_edges, 1 ) );
+  std::cout << std::left
+    << std::setw( 10 ) << graph_shape_name( shape )
+    << std::right
+    << std::setw( 11 ) << num_edges << "  "
+    << std::left
+    << std::setw( 40 ) << phase
+    << std::right << std::fixed
+    << std::setw( 12 ) << std::setprecision( 3 ) << elapsed.count() / 1e6
+    << std::setw( 10 ) << std::setprecision( 2 ) << elapsed.count() / edges
+    << std::setw( 12 ) << std::setprecision( 2 ) << edges / elapsed.count() * 1e3
+    << std::setw( 11 ) << std::setprecision( 1 );
+  // Without a reset the peak is the whole run's, which says nothing about
+  // this phase
+  if ( rss_reset ) {
+    std::cout << peak_rss_mb();
+  }
+  else {
+    std::cout << "-";
+  }
+  std::cout << "\n";
+  return result;
+}
+
+/// @brief Throw if an engine's count doesn't match count_connected
+void check_count( std::string_view engine, int count, int expected )
+{
+  if ( count != expected ) {
+    throw std::logic_error( std::string( engine ) + " counted " + std::to_string( count )
+      + " connected subgraphs, count_connected counted " + std::to_string( expected ) );
+  }
+}
+
+///
+/// @brief Benchmark batched connectivity queries on a CSR graph
+///
+/// The batch goes through connected_avx2 where the CPU has it, which the
+/// header's static_asserts can't reach, so every answer is checked against
+/// the one pair connected.  The batch isn't a whole number of the four
+/// pairs connected_avx2 answers at once, and a node past the graph must
+/// still throw.
+///
+void benchmark_queries( graph_shape_t shape, size_t num_edges, const runtime_csr_t& csr )
+{
+  const connectivity_query_t query{ csr };
+  const size_t num_nodes = csr.get_num_nodes();
+  if ( num_nodes == 0 ) {
+    return;
+  }
+
+  std::mt19937_64 rng{ 1 };
+  std::uniform_int_distribution< size_t > pick{ 0, num_nodes - 1 };
+  std::vector< node_pair_t > queries( num_edges / 4 * 4 + 3 );
+  for ( node_pair_t& pair : queries ) {
+    pair = { node_id_t{ pick( rng ) }, node_id_t{ pick( rng ) } };
+  }
+  const auto batch = std::make_unique< bool[] >( queries.size() );
+
+  benchmark_phase( shape, queries.size(), "connectivity queries (batch)", [ & ]() {
+    query.connected( queries, std::span< bool >{ batch.get(), queries.size() } );
+    return 0;
+  } );
+  for ( size_t idx = 0; idx < queries.size(); ++idx ) {
+    if ( batch[ idx ] != query.connected( queries[ idx ].node_a, queries[ idx ].node_b ) ) {
+      throw std::logic_error( "batched connectivity query " + std::to_string( idx ) + " disagrees with connected" );
+    }
+  }
+
+  // The out of range node is in the second block of four
+  std::vector< node_pair_t > past_end( 8, node_pair_t{ node_id_t{ 0 }, node_id_t{ 0 } } );
+  past_end[ 5 ].node_b = node_id_t{ num_nodes };
+  bool past_end_answers[ 8 ] = {};
+  try {
+    query.connected( past_end, past_end_answers );
+  }
+  catch ( const std::out_of_range& ) {
+    return;
+  }
+  throw std::logic_error( "batched connectivity query didn't throw for a node past the graph" );
+}
+
+///
+/// @brief Benchmark the parallel parse and build phases, and --dedup's
+///
+/// Each parallel phase runs on 1 thread and on options.threads threads, so
+/// the rows show how parsing scales.  The graphs built have to match the
+/// serial ones.
+///
+void benchmark_parallel_loading( graph_shape_t shape, size_t num_edges, std::string_view text,
+  const runtime_csr_t& csr, const benchmark_options_t& options )
+{
+  const auto phase = [ & ]( std::string_view name, auto func ) {
+    return benchmark_phase( shape, num_edges, name, func );
+  };
+  const auto check_edges = [ & ]( std::string_view name, size_t count ) {
+    if ( count != csr.get_num_edges() ) {
+      throw std::logic_error( std::string( name ) + " built " + std::to_string( count )
+        + " edges, read_graph_csr built " + std::to_string( csr.get_num_edges() ) );
+    }
+  };
+
+  std::vector< unsigned > thread_counts{ 1 };
+  if ( options.threads > 1 ) {
+    thread_counts.push_back( options.threads );
+  }
+  for ( const unsigned threads : thread_counts ) {
+    const std::string suffix = " (" + std::to_string( threads ) + ( threads == 1 ? " thread)" : " threads)" );
+    thread_pool_t pool{ threads };
+    const parsed_edges_t parsed = phase( "parse_edges_parallel" + suffix, [ & ]() {
+      return parse_edges_parallel( text, pool );
+    } );
+    check_edges( "make_csr_parallel" + suffix, phase( "make_csr_parallel" + suffix, [ & ]() {
+      return make_csr_parallel< runtime_csr_t >( parsed.get_num_nodes(), parsed.get_num_chunks(),
+        [ & ]( size_t chunk, auto add_edge ) { parsed.for_each_chunk_edge( chunk, add_edge ); }, pool );
+    } ).get_num_edges() );
+    check_edges( "read_graph_csr_parallel" + suffix, phase( "read_graph_csr_parallel" + suffix, [ & ]() {
+      return read_graph_csr_parallel< runtime_csr_t >( text, threads );
+    } ).get_num_edges() );
+    check_edges( "read_graph_parallel" + suffix, phase( "read_graph_parallel" + suffix, [ & ]() {
+      return read_graph_parallel< runtime_graph_t >( text, threads );
+    } ).get_num_edges() );
+  }
+
+  // --dedup.  With --threads, main parses in parallel and runs dedup_edges
+  // on the result, which is what the second row times.
+  const deduped_edges_t deduped = phase( "dedup_text_edges", [ & ]() { return dedup_text_edges( text ); } );
+  thread_pool_t pool{ options.threads };
+  const parsed_edges_t parsed = parse_edges_parallel( text, pool );
+  const deduped_edges_t parsed_deduped = phase( "dedup_edges (parsed)", [ & ]() {
+    return dedup_edges( parsed.get_num_nodes(), parsed.get_num_edges(), [ & ]( auto add_edge ) {
+      parsed.for_each_edge( add_edge );
+    } );
+  } );
+  if ( deduped.get_num_edges() != parsed_deduped.get_num_edges() ) {
+    throw std::logic_error( "dedup_text_edges and dedup_edges kept different edges" );
+  }
+}
+
+///
+/// @brief Benchmark writing a CSR file and mapping it back
+///
+/// The file is in the page cache when it's loaded, so the load rows time
+/// the checks rather than the disk.  The default load only reads the
+/// header; --verify-csr's reads every offset and id.
+///
+void benchmark_csr_file( graph_shape_t shape, size_t num_edges, const runtime_csr_t& csr, int expected )
+{
+  const auto phase = [ & ]( std::string_view name, auto func ) {
+    return benchmark_phase( shape, num_edges, name, func );
+  };
+  const std::string path = ( std::filesystem::temp_directory_path()
+    / ( "benchmark_" + std::to_string( ::getpid() ) + ".csr" ) ).string();
+
+  phase( "write_csr_file", [ & ]() { write_csr_file( csr, path.c_str() ); return 0; } );
+  try {
+    phase( "load_csr_file (--verify-csr)", [ & ]() {
+      return mapped_csr_t{ path.c_str(), csr_check_t::full }.get_num_edges();
+    } );
+    const mapped_csr_t mapped = phase( "load_csr_file", [ & ]() {
+      return mapped_csr_t{ path.c_str() };
+    } );
+    check_count( "count_connected (csr file, + doubling)", phase( "count_connected (csr file, + doubling)", [ & ]() {
+      return count_connected( mapped );
+    } ), expected );
+  }
+  catch ( ... ) {
+    std::filesystem::remove( path );
+    throw;
+  }
+  std::filesystem::remove( path );
+}
+
+///
+/// @brief Benchmark every phase and engine on one generated graph
+///
+void benchmark_graph( graph_shape_t shape, size_t num_edges, const benchmark_options_t& options )
+{
+  const generated_graph_t generated = generate_graph( shape, num_edges );
+  const std::string_view text = generated.text;
+  const size_t edges = generated.num_edges;
+  const auto phase = [ & ]( std::string_view name, auto func ) {
+    return benchmark_phase( shape, edges, name, func );
+  };
+
+  // Graph build phases
+  const auto graph = phase( "read_graph", [ & ]() { return read_graph< runtime_graph_t >( text ); } );
+  phase( "double_up_edges", [ & ]() { return double_up_edges( graph ).get_num_edges(); } );
+  const auto csr = phase( "read_graph_csr", [ & ]() { return read_graph_csr< runtime_csr_t >( text ); } );
+  phase( "double_up_edges (csr)", [ & ]() { return double_up_edges( csr ).get_num_edges(); } );
+  const auto undirected = phase( "read_graph (undirected)", [ & ]() {
+    return read_graph< runtime_undirected_graph_t >( text );
+  } );
+
+  // Engines.  count_connected doubles up a graph_raw or a CSR graph itself,
+  // so those two rows include a double_up_edges each, which the
+  // double_up_edges rows above time on their own.  graph_undirected needs
+  // no copy.
+  const int expected = phase( "count_connected (+ doubling)", [ & ]() { return count_connected( graph ); } );
+  check_count( "count_connected (csr, + doubling)", phase( "count_connected (csr, + doubling)", [ & ]() {
+    return count_connected( csr );
+  } ), expected );
+  check_count( "count_connected (undirected)", phase( "count_connected (undirected)", [ & ]() {
+    return count_connected( undirected );
+  } ), expected );
+  check_count( "count_connected_bfs", phase( "count_connected_bfs", [ & ]() {
+    return static_cast< int >( count_connected_bfs( csr ).num_components );
+  } ), expected );
+  check_count( "label_propagation", phase( "label_propagation", [ & ]() {
+    return static_cast< int >( count_connected_label_propagation( csr ).num_components );
+  } ), expected );
+  check_count( "count_connected_union_find", phase( "count_connected_union_find", [ & ]() {
+    return count_connected_union_find( graph );
+  } ), expected );
+  check_count( "union_find_text", phase( "union_find_text", [ & ]() {
+    return count_connected_union_find( text );
+  } ), expected );
+  check_count( "tracked read_graph", phase( "tracked read_graph", [ & ]() {
+    return static_cast< int >( read_graph< runtime_tracked_graph_t >( text ).get_num_components() );
+  } ), expected );
+  thread_pool_t pool{ options.threads };
+  check_count( "count_connected_afforest", phase( "count_connected_afforest", [ & ]() {
+    return count_connected_afforest( csr, pool );
+  } ), expected );
+  check_count( "count_connected_concurrent", phase( "count_connected_concurrent", [ & ]() {
+    return count_connected_concurrent( text, pool );
+  } ), expected );
+
+  benchmark_queries( shape, edges, csr );
+  benchmark_parallel_loading( shape, edges, text, csr, options );
+  benchmark_csr_file( shape, edges, csr, expected );
+
+  // The CSR graph relabeled in each node order.  Counts don't change, but
+  // traversals touch memory in order.
+  for ( const node_order_t order : all_node_orders ) {
+    const std::string order_name{ node_order_name( order ) };
+    const auto reordered = phase( "reorder_nodes (" + order_name + ")", [ & ]() {
+      return reorder_nodes( csr, order ).graph;
+    } );
+    check_count( "count_connected (" + order_name + ")", phase( "count_connected (" + order_name + ")", [ & ]() {
+      return count_connected( reordered );
+    } ), expected );
+  }
+}
+
+///
+/// @brief Benchmark count_connected on many tiny graphs of one shape
+///
+/// The graphs have at most 64 nodes, so count_connected uses
+/// count_connected_bit_parallel.  count_connected_dfs on the same graphs
+/// is the comparison.  The edge count is the total over every graph.
+///
+void benchmark_small_graphs( graph_shape_t shape )
+{
+  constexpr size_t num_graphs = 10000;
+  constexpr size_t edges_per_graph = 60;
+  // Room for count_connected_dfs's doubled up copy
+  using small_graph_t = graph_raw< 64, edges_per_graph * 2 >;
+
+  std::vector< small_graph_t > graphs;
+  size_t total_edges = 0;
+  for ( size_t seed = 1; seed <= num_graphs; ++seed ) {
+    const generated_graph_t generated = generate_graph( shape, edges_per_graph, seed );
+    graphs.push_back( read_graph< small_graph_t >( generated.text ) );
+    total_edges += generated.num_edges;
+  }
+  const auto count_all = [ & ]( auto count ) {
+    int total = 0;
+    for ( const small_graph_t& graph : graphs ) {
+      total += count( graph );
+    }
+    return total;
+  };
+
+  const int expected = benchmark_phase( shape, total_edges, "64 node graphs, dfs", [ & ]() {
+    return count_all( []( const small_graph_t& graph ) { return count_connected_dfs( graph ); } );
+  } );
+  check_count( "64 node graphs, bit parallel", benchmark_phase( shape, total_edges, "64 node graphs, bit parallel", [ & ]() {
+    return count_all( []( const small_graph_t& graph ) { return count_connected( graph ); } );
+  } ), expected );
+}
+
+///
+/// Usage: benchmark [--min-edges=<n>] [--max-edges=<n>] [--shapes=<s>,<s>...] [--threads=<n>]
+///
+/// Shapes are random, chain, star, grid and power_law.  Prints one row per
+/// phase: time, ns per edge, million edges per second and the peak RSS
+/// during the phase, or - where the peak can't be reset.  Each shape
+/// starts with rows for 10000 graphs of 60 edges.
+///
+int main( int argc, const char *argv[] ) {
+  benchmark_options_t options;
+
+  try {
+    for ( int arg = 1; arg < argc; ++arg ) {
+      const std::string_view option{ argv[arg] };
+      const auto value = [ & ]( std::string_view name ) {
+        return std::string( option.substr( name.size() ) );
+      };
+      if ( option.starts_with( "--min-edges=" ) ) {
+        options.min_edges = static_cast< size_t >( std::stod( value( "--min-edges=" ) ) );
+      }
+      else if ( option.starts_with( "--max-edges=" ) ) {
+        options.max_edges = static_cast< size_t >( std::stod( value( "--max-edges=" ) ) );
+      }
+      else if ( option.starts_with( "--threads=" ) ) {
+        options.threads = parse_thread_count( value( "--threads=" ) );
+      }
+      else if ( option.starts_with( "--shapes=" ) ) {
+        std::string_view names = option.substr( std::string_view{ "--shapes=" }.size() );
+        while ( !names.empty() ) {
+          const size_t comma = std::min( names.find( ',' ), names.size() );
+          options.shapes.push_back( parse_graph_shape( names.substr( 0, comma ) ) );
+          names.remove_prefix( std::min( comma + 1, names.size() ) );
+        }
+      }
+      else {
+        throw std::invalid_argument( "unknown option " + std::string( option ) );
+      }
+    }
+    if ( options.shapes.empty() ) {
+      options.shapes.assign( std::begin( all_graph_shapes ), std::end( all_graph_shapes ) );
+    }
+
+    std::cout << std::left << std::setw( 10 ) << "shape" << std::right << std::setw( 11 ) << "edges" << "  "
+      << std::left << std::setw( 40 ) << "phase" << std::right << std::setw( 12 ) << "ms"
+      << std::setw( 10 ) << "ns/edge" << std::setw( 12 ) << "Medges/s" << std::setw( 11 ) << "peak MB" << "\n";
+    for ( const graph_shape_t shape : options.shapes ) {
+      benchmark_small_graphs( shape );
+      for ( size_t num_edges = options.min_edges; num_edges <= options.max_edges; num_edges *= 10 ) {
+        benchmark_graph( shape, num_edges, options );
+      }
+    }
+    return 0;
+  }
+  catch( const std::exception& e ) {
+    std::cerr << argv[0] << ": " << e.what() << "\n";
+    return 1;
+  }
+}
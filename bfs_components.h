@@ -0,0 +1,178 @@
+#ifndef __BFS_COMPONENTS_H__
+#define __BFS_COMPONENTS_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "bitset.h"
+#include "connected.h"
+#include "graph_csr.h"
+
+///
+/// @brief When count_connected_bfs switches between top-down and bottom-up
+///        steps
+///
+/// The defaults are the ones from Beamer, Asanovic and Patterson's
+/// direction optimizing BFS paper.
+///
+struct bfs_tuning_t {
+  /// Go bottom-up when the frontier's edges are more than 1 / alpha of the
+  /// edges of the nodes that haven't been visited yet
+  size_t alpha = 14;
+  /// Go back to top-down when the frontier has fewer than 1 / beta of the
+  /// graph's nodes
+  size_t beta = 24;
+};
+
+///
+/// @brief What count_connected_bfs found, and how much work it took
+///
+struct bfs_components_t {
+  size_t num_components = 0;
+  /// Neighbor ids read.  A DFS reads every one of the doubled up graph's
+  /// edges, i.e., twice the input edges.
+  size_t edges_inspected = 0;
+  size_t top_down_steps = 0;
+  size_t bottom_up_steps = 0;
+};
+
+///
+/// @brief Count connected subgraphs with a direction optimizing BFS
+///
+/// @param graph   A CSR graph - graph_csr or mapped_csr_t.  Edges are
+///                doubled up, like count_connected does.
+/// @param tuning  When to switch directions
+///
+/// Each component is a BFS from its lowest numbered node.  A top-down step
+/// follows every edge out of the frontier, which is wasted work once most
+/// of those edges lead to nodes that are already visited - typical in the
+/// middle steps on a giant component.  A bottom-up step instead has each
+/// unvisited node look for any neighbor in the frontier, and stop at the
+/// first one it finds.  The frontier is a bitset in bottom-up steps, so the
+/// lookups are a bit test each.
+///
+template< typename graph_type >
+constexpr bfs_components_t count_connected_bfs( const graph_type& graph, bfs_tuning_t tuning = {} )
+{
+  const auto& bidir_graph = as_bidirectional( graph );
+  const size_t num_nodes = bidir_graph.get_num_nodes();
+  const auto degree = [ & ]( size_t node ) {
+    return bidir_graph.neighbors( node_id_t{ node } ).size();
+  };
+
+  bfs_components_t result;
+  node_set_t< graph_type > visited{ num_nodes };
+  node_set_t< graph_type > frontier_set{ num_nodes };
+  node_set_t< graph_type > next_set{ num_nodes };
+  std::vector< node_id_t > frontier;
+  std::vector< node_id_t > next;
+
+  // Edges of nodes that haven't been visited
+  size_t unexplored_edges = bidir_graph.get_num_edges();
+
+  for ( size_t start = visited.find_next_unset( 0 );
+        start < num_nodes;
+        start = visited.find_next_unset( start + 1 ) ) {
+    ++result.num_components;
+    visited.set( start );
+    if ( degree( start ) == 0 ) {
+      // Isolated node, nothing to search
+      continue;
+    }
+    unexplored_edges -= degree( start );
+    frontier.assign( 1, node_id_t{ start } );
+    size_t frontier_size = 1;
+    size_t frontier_edges = degree( start );
+    bool bottom_up = false;
+
+    while ( frontier_size > 0 ) {
+      // Pick a direction.  The frontier changes representation with it.
+      if ( !bottom_up && frontier_edges > unexplored_edges / tuning.alpha ) {
+        bottom_up = true;
+        frontier_set.clear();
+        for ( const node_id_t node : frontier ) {
+          frontier_set.set( node.value() );
+        }
+      }
+      else if ( bottom_up && frontier_size < num_nodes / tuning.beta ) {
+        bottom_up = false;
+        frontier.clear();
+        for ( size_t node = frontier_set.find_next_set( 0 ); node < num_nodes;
+              node = frontier_set.find_next_set( node + 1 ) ) {
+          frontier.push_back( node_id_t{ node } );
+        }
+      }
+
+      size_t next_size = 0;
+      size_t next_edges = 0;
+      const auto visit = [ & ]( size_t node ) {
+        visited.set( node );
+        ++next_size;
+        next_edges += degree( node );
+        unexplored_edges -= degree( node );
+      };
+
+      if ( bottom_up ) {
+        ++result.bottom_up_steps;
+        next_set.clear();
+        for ( size_t node = visited.find_next_unset( 0 ); node < num_nodes;
+              node = visited.find_next_unset( node + 1 ) ) {
+          for ( const node_id_t parent : bidir_graph.neighbors( node_id_t{ node } ) ) {
+            ++result.edges_inspected;
+            if ( frontier_set.test( parent.value() ) ) {
+              next_set.set( node );
+              visit( node );
+              break;
+            }
+          }
+        }
+        std::swap( frontier_set, next_set );
+      }
+      else {
+        ++result.top_down_steps;
+        next.clear();
+        for ( const node_id_t src_node : frontier ) {
+          for ( const node_id_t dst_node : bidir_graph.neighbors( src_node ) ) {
+            ++result.edges_inspected;
+            if ( !visited.test( dst_node.value() ) ) {
+              next.push_back( dst_node );
+              visit( dst_node.value() );
+            }
+          }
+        }
+        std::swap( frontier, next );
+      }
+      frontier_size = next_size;
+      frontier_edges = next_edges;
+    }
+  }
+  return result;
+}
+
+#ifndef NO_HEADER_TESTS
+// A star that goes bottom-up with alpha = 2, plus a separate pair
+static_assert( []() {
+  const auto star = read_graph_csr< graph_csr< 9, 14 > >( "9 0 1 0 2 0 3 0 4 0 5 5 6 7 8" );
+  const bfs_components_t result = count_connected_bfs( star, bfs_tuning_t{ 2, 24 } );
+  return result.num_components == 2 && result.bottom_up_steps > 0;
+}() );
+
+// With the default tuning, a hub with 40 spokes sends the search
+// bottom-up, and the 30 node tail off the last spoke brings it back
+// top-down
+static_assert( []() {
+  graph_raw< 74, 71 > hub_and_tail{ 74 };
+  for ( size_t idx = 1; idx <= 40; ++idx ) {
+    hub_and_tail.add_edge( node_id_t{ 0 }, node_id_t{ idx } );
+  }
+  for ( size_t idx = 41; idx <= 70; ++idx ) {
+    hub_and_tail.add_edge( node_id_t{ idx - 1 }, node_id_t{ idx } );
+  }
+  hub_and_tail.add_edge( node_id_t{ 72 }, node_id_t{ 71 } );
+  const bfs_components_t result = count_connected_bfs( make_csr< graph_csr< 74, 142 > >( hub_and_tail ) );
+  return result.num_components == 3 && result.bottom_up_steps > 0 && result.top_down_steps > 0;
+}() );
+#endif
+
+#endif
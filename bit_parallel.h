@@ -0,0 +1,160 @@
+#ifndef __BIT_PARALLEL_H__
+#define __BIT_PARALLEL_H__
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "graph_raw.h"
+
+/// @brief Graphs with at most this many nodes are counted with
+///        count_connected_bit_parallel
+inline constexpr size_t bit_parallel_max_nodes = 128;
+
+///
+/// @brief A set of nodes of a graph with at most max_nodes nodes, one bit
+///        per node, in one or two uint64_ts
+///
+/// The word count is a compile time constant, so every loop over the words
+/// is unrolled.
+///
+template< size_t max_nodes >
+class node_mask_t {
+  public:
+
+  static_assert( max_nodes <= bit_parallel_max_nodes );
+  static constexpr size_t num_words = max_nodes <= 64 ? 1 : 2;
+
+  constexpr void set( size_t node ) {
+    words[ node / 64 ] |= uint64_t{ 1 } << ( node % 64 );
+  }
+
+  constexpr bool empty() const {
+    bool result = true;
+    for ( size_t word = 0; word < num_words; ++word ) {
+      result &= words[ word ] == 0;
+    }
+    return result;
+  }
+
+  /// @brief Gets the lowest numbered node in the set.  It must not be empty.
+  constexpr size_t lowest() const {
+    if constexpr ( num_words == 1 ) {
+      return static_cast< size_t >( std::countr_zero( words[ 0 ] ) );
+    }
+    else {
+      return words[ 0 ] != 0
+        ? static_cast< size_t >( std::countr_zero( words[ 0 ] ) )
+        : 64 + static_cast< size_t >( std::countr_zero( words[ 1 ] ) );
+    }
+  }
+
+  /// @brief Remove and return the lowest numbered node
+  constexpr size_t pop_lowest() {
+    const size_t node = lowest();
+    words[ node / 64 ] &= words[ node / 64 ] - 1;
+    return node;
+  }
+
+  constexpr node_mask_t& operator|=( const node_mask_t& other ) {
+    for ( size_t word = 0; word < num_words; ++word ) {
+      words[ word ] |= other.words[ word ];
+    }
+    return *this;
+  }
+
+  /// @brief The nodes in this set that aren't in other
+  constexpr node_mask_t minus( const node_mask_t& other ) const {
+    node_mask_t result;
+    for ( size_t word = 0; word < num_words; ++word ) {
+      result.words[ word ] = words[ word ] & ~other.words[ word ];
+    }
+    return result;
+  }
+
+  /// @brief The first num_nodes nodes
+  static constexpr node_mask_t first( size_t num_nodes ) {
+    node_mask_t result;
+    for ( size_t word = 0; word < num_words; ++word ) {
+      const size_t bits = num_nodes > word * 64 ? num_nodes - word * 64 : 0;
+      result.words[ word ] = bits >= 64 ? ~uint64_t{ 0 } : ( uint64_t{ 1 } << bits ) - 1;
+    }
+    return result;
+  }
+
+  private:
+  std::array< uint64_t, num_words > words{};
+};
+
+///
+/// @brief Count connected subgraphs of a graph with at most 128 nodes
+///
+/// Each node's neighbors, in both directions, become a bitmask.  A
+/// component grows from its lowest unclaimed node: every node that joins is
+/// taken off a pending mask once, and its mask ORed in, with the new nodes
+/// going on the pending mask.  There's no visited array, no frontier stack
+/// and no doubled up graph - the whole search is a few words of state.
+///
+/// count_connected picks this for any graph type whose max_num_nodes is
+/// bit_parallel_max_nodes or less.
+///
+template< typename graph_type >
+constexpr int count_connected_bit_parallel( const graph_type& graph )
+{
+  constexpr size_t max_nodes = graph_type::max_num_nodes;
+  using mask_t = node_mask_t< max_nodes >;
+
+  const size_t num_nodes = graph.get_num_nodes();
+  std::array< mask_t, max_nodes > adjacency{};
+  for ( size_t idx = 0; idx < num_nodes; ++idx ) {
+    for ( const node_id_t dst_node : graph.neighbors( node_id_t{ idx } ) ) {
+      // A bad edge would set a bit past the adjacency array, or one past
+      // num_nodes that unclaimed never clears
+      if ( dst_node.value() >= num_nodes ) {
+        throw std::out_of_range( "count_connected_bit_parallel: edge to a node past num_nodes" );
+      }
+      adjacency[ idx ].set( dst_node.value() );
+      adjacency[ dst_node.value() ].set( idx );
+    }
+  }
+
+  int subgraph_count = 0;
+  mask_t unclaimed = mask_t::first( num_nodes );
+  while ( !unclaimed.empty() ) {
+    ++subgraph_count;
+    mask_t component;
+    mask_t pending;
+    pending.set( unclaimed.lowest() );
+    component |= pending;
+    while ( !pending.empty() ) {
+      const mask_t found = adjacency[ pending.pop_lowest() ].minus( component );
+      component |= found;
+      pending |= found;
+    }
+    unclaimed = unclaimed.minus( component );
+  }
+  return subgraph_count;
+}
+
+#ifndef NO_HEADER_TESTS
+// Two words.  99 is linked to 0 in the other word and 65 to 99, and 63 and
+// 64 sit either side of the boundary.
+static_assert( count_connected_bit_parallel( read_graph< graph_raw< 100, 3 > >( "100 99 0 63 64 65 99" ) ) == 97 );
+
+// Exactly 64 nodes fill word 0, in a one word mask and in a two word one
+static_assert( count_connected_bit_parallel( read_graph< graph_raw< 64, 1 > >( "64 63 0" ) ) == 63 );
+static_assert( count_connected_bit_parallel( read_graph< graph_raw< 100, 1 > >( "64 63 0" ) ) == 63 );
+
+// Two words, with a component crossing between them
+static_assert( []() {
+  graph_raw< 128, 127 > chain{ 128 };
+  for ( size_t idx = 1; idx < 100; ++idx ) {
+    chain.add_edge( node_id_t{ idx }, node_id_t{ idx - 1 } );
+  }
+  return count_connected_bit_parallel( chain ) == 29;
+}() );
+#endif
+
+#endif
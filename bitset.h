@@ -0,0 +1,161 @@
+#ifndef __BITSET_H__
+#define __BITSET_H__
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "sized_storage.h"
+
+///
+/// @brief Fixed size bitset for per node flags (visited, frontier)
+///
+/// One bit per node, packed into 64 bit words, so it's 8x smaller than a
+/// bool array and scans for set or clear bits go a word at a time using
+/// count trailing zeros.  Everything is constexpr.
+///
+/// max_bits may be dynamic_size, in which case storage is sized when the
+/// bitset is constructed.  Bits past size() are always zero.
+///
+template< size_t max_bits >
+class bitset_t {
+  public:
+
+  using word_t = uint64_t;
+  static constexpr size_t bits_per_word = 64;
+
+  /// @brief Number of words needed to hold num_bits bits
+  static constexpr size_t words_for( size_t num_bits ) {
+    return ( num_bits + bits_per_word - 1 ) / bits_per_word;
+  }
+
+  static constexpr size_t max_words = max_bits == dynamic_size ? dynamic_size : words_for( max_bits );
+
+  bitset_t() = delete;
+
+  /// @brief Create a bitset of num_bits_arg bits, all clear
+  constexpr explicit bitset_t( size_t num_bits_arg ) :
+    num_bits{ num_bits_arg },
+    words{ make_sized_array< word_t, max_words >( words_for( num_bits_arg ) ) }
+  {}
+
+  /// @brief Gets the number of bits
+  constexpr size_t size() const {
+    return num_bits;
+  }
+
+  /// @brief Returns true if bit idx is set
+  constexpr bool test( size_t idx ) const {
+    return ( word_at( idx ) >> ( idx % bits_per_word ) ) & 1;
+  }
+
+  /// @brief Set bit idx
+  constexpr void set( size_t idx ) {
+    word_at( idx ) |= word_t{ 1 } << ( idx % bits_per_word );
+  }
+
+  /// @brief Clear bit idx
+  constexpr void reset( size_t idx ) {
+    word_at( idx ) &= ~( word_t{ 1 } << ( idx % bits_per_word ) );
+  }
+
+  /// @brief Clear every bit
+  constexpr void clear() {
+    for ( auto& word : words ) { word = 0; }
+  }
+
+  /// @brief Gets the number of set bits
+  constexpr size_t count() const {
+    size_t total = 0;
+    for ( const word_t word : words ) {
+      total += std::popcount( word );
+    }
+    return total;
+  }
+
+  /// @brief Find the first set bit at or after idx
+  ///
+  /// @return The bit's index, or size() if there isn't one
+  ///
+  constexpr size_t find_next_set( size_t idx ) const {
+    return find_next( idx, word_t{ 0 } );
+  }
+
+  /// @brief Find the first clear bit at or after idx
+  ///
+  /// @return The bit's index, or size() if there isn't one
+  ///
+  constexpr size_t find_next_unset( size_t idx ) const {
+    return find_next( idx, ~word_t{ 0 } );
+  }
+
+  /// @brief Get the word holding bits [ word_idx * 64, word_idx * 64 + 64 )
+  constexpr word_t get_word( size_t word_idx ) const {
+    return words.at( word_idx );
+  }
+
+  /// @brief Gets the number of words
+  constexpr size_t num_words() const {
+    return words_for( num_bits );
+  }
+
+  private:
+
+  constexpr word_t& word_at( size_t idx ) {
+    return words.at( idx / bits_per_word );
+  }
+
+  constexpr const word_t& word_at( size_t idx ) const {
+    return words.at( idx / bits_per_word );
+  }
+
+  /// Scan for the first bit at or after idx that is set in ( word ^ flip ).
+  /// flip is all ones to look for clear bits, zero to look for set ones.
+  constexpr size_t find_next( size_t idx, word_t flip ) const {
+    if ( idx >= num_bits ) {
+      return num_bits;
+    }
+    size_t word_idx = idx / bits_per_word;
+    // Ignore bits below idx in the first word
+    word_t word = ( words.at( word_idx ) ^ flip ) & ( ~word_t{ 0 } << ( idx % bits_per_word ) );
+
+    while ( word == 0 ) {
+      ++word_idx;
+      if ( word_idx >= num_words() ) {
+        return num_bits;
+      }
+      word = words.at( word_idx ) ^ flip;
+    }
+    const size_t found = word_idx * bits_per_word + std::countr_zero( word );
+    // Clear bits past the end of the last word can look like a match
+    return found < num_bits ? found : num_bits;
+  }
+
+  size_t num_bits;
+  sized_array_t< word_t, max_words > words;
+};
+
+#ifndef NO_HEADER_TESTS
+static_assert( []() {
+  bitset_t< 200 > bits{ 130 };
+  bits.set( 0 );
+  bits.set( 64 );
+  bits.set( 129 );
+  return bits.count() == 3
+    && bits.test( 64 ) && !bits.test( 63 )
+    && bits.find_next_set( 1 ) == 64
+    && bits.find_next_set( 65 ) == 129
+    && bits.find_next_unset( 0 ) == 1
+    && bits.find_next_unset( 129 ) == 130;
+}() );
+
+static_assert( []() {
+  bitset_t< 128 > bits{ 70 };
+  for ( size_t idx = 0; idx < 70; ++idx ) { bits.set( idx ); }
+  bits.reset( 69 );
+  return bits.find_next_unset( 0 ) == 69 && bits.find_next_set( 69 ) == 70;
+}() );
+#endif
+
+#endif
+
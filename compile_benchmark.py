@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""Compile time cost of the constexpr graph evaluation.
+
+Generates graph.h style inputs of increasing size and compiles main.cpp
+against each one.  For each size and each phase (see COMPILE_TIME_PHASE in
+main.cpp) it records:
+
+  - wall time of the compile
+  - peak RSS of the compiler
+  - the smallest -fconstexpr-ops-limit and -fconstexpr-loop-limit the
+    phase compiles with (to within --precision)
+
+Limits are per constant expression, so a phase's minimum is the minimum for
+its most expensive expression.  Every build has -DNO_HEADER_TESTS, which
+leaves out the static_asserts the headers test themselves with - they'd
+otherwise set the minimum for any phase cheaper than they are.  Phase 0
+(baseline) then evaluates almost nothing.  The compile time graph is a
+graph_undirected, which needs no doubled up copy, so phase 2 (raw_bidir)
+measures what it saves: phase 1, plus the graph parsed into a graph_raw and
+run through double_up_edges.
+
+Usage: ./compile_benchmark.py [--nodes=1000,2500,5000,10000] [--phases=0,1,2,3]
+                              [--no-limits] [--cxx=g++]
+"""
+
+import argparse
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.abspath(__file__))
+
+# Limits high enough for any size this script generates
+MAX_OPS_LIMIT = 1 << 40
+MAX_LOOP_LIMIT = (1 << 31) - 1
+
+PHASES = {0: "baseline", 1: "parse", 2: "raw_bidir", 3: "traverse"}
+
+
+def generate_graph(num_nodes, num_edges, seed):
+    """Random graph text in graph.h's format, and its component count."""
+    rng = random.Random(seed)
+    parent = list(range(num_nodes))
+
+    def find(node):
+        while parent[node] != node:
+            parent[node] = parent[parent[node]]
+            node = parent[node]
+        return node
+
+    lines = [str(num_nodes)]
+    components = num_nodes
+    for _ in range(num_edges):
+        src, dst = rng.randrange(num_nodes), rng.randrange(num_nodes)
+        lines.append(f"{src} {dst}")
+        root_src, root_dst = find(src), find(dst)
+        if root_src != root_dst:
+            parent[root_src] = root_dst
+            components -= 1
+    return 'constexpr char input[]=R"(' + "\n".join(lines) + '\n)";\n', components
+
+
+def compile_main(args, header, expected, phase, ops_limit, loop_limit, syntax_only):
+    """Compile main.cpp.  Returns (succeeded, wall seconds, peak RSS in MB)."""
+    command = [
+        args.cxx, "-std=c++20", "-pthread", "-O",
+        f"-fconstexpr-ops-limit={ops_limit}",
+        f"-fconstexpr-loop-limit={loop_limit}",
+        f"-DGRAPH_HEADER=\"{header}\"",
+        f"-DEXPECTED_SUBGRAPHS={expected}",
+        f"-DCOMPILE_TIME_PHASE={phase}",
+        "-DNO_HEADER_TESTS",
+        "-I", REPO,
+        os.path.join(REPO, "main.cpp"),
+    ]
+    command += ["-fsyntax-only"] if syntax_only else ["-c", "-o", os.devnull]
+
+    # stderr goes to a file rather than a pipe.  A limit failure can write
+    # tens of KB of errors, and a full pipe would block the compiler while
+    # wait4 waits for it.
+    with tempfile.TemporaryFile() as stderr_file:
+        start = time.monotonic()
+        process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=stderr_file)
+        # wait4's usage covers the compiler driver and the cc1plus it waited for
+        _, status, usage = os.wait4(process.pid, 0)
+        elapsed = time.monotonic() - start
+        stderr_file.seek(0)
+        stderr = stderr_file.read().decode(errors="replace")
+    succeeded = os.waitstatus_to_exitcode(status) == 0
+    if not succeeded and "exceeds limit" not in stderr and "exceeded" not in stderr:
+        # Not a limit failure - the build is broken, so the numbers would be too
+        sys.exit(f"compile failed:\n{' '.join(command)}\n{stderr}")
+    return succeeded, elapsed, usage.ru_maxrss / 1024.0
+
+
+def min_limit(compiles, low, high, precision):
+    """Smallest limit in (low, high] that compiles(limit) accepts.
+
+    compiles(high) must succeed.  Bisects in log space, so the answer is
+    within a factor of (1 + precision) of the real minimum.
+    """
+    while high > low * (1 + precision) and high - low > 1:
+        middle = int((low * high) ** 0.5)
+        middle = min(max(middle, low + 1), high - 1)
+        if compiles(middle):
+            high = middle
+        else:
+            low = middle
+    return high
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--nodes", default="1000,2500,5000,10000",
+                        help="comma separated node counts, one input per count")
+    parser.add_argument("--edges-per-node", type=float, default=3.3,
+                        help="edges per node, 3.3 like graph.h")
+    parser.add_argument("--phases", default="0,1,2,3", help="COMPILE_TIME_PHASEs to build")
+    parser.add_argument("--no-limits", action="store_true", help="skip the limit searches")
+    parser.add_argument("--precision", type=float, default=0.05,
+                        help="relative precision of the limit searches")
+    parser.add_argument("--cxx", default="g++")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    phases = [int(phase) for phase in args.phases.split(",")]
+    print(f"{'nodes':>8} {'edges':>8} {'phase':>10} {'wall s':>8} {'peak MB':>8} "
+          f"{'min ops limit':>14} {'min loop limit':>15}", flush=True)
+
+    with tempfile.TemporaryDirectory() as work_dir:
+        for num_nodes in (int(nodes) for nodes in args.nodes.split(",")):
+            num_edges = int(num_nodes * args.edges_per_node)
+            text, expected = generate_graph(num_nodes, num_edges, args.seed)
+            header = os.path.join(work_dir, f"graph_{num_nodes}.h")
+            with open(header, "w") as header_file:
+                header_file.write(text)
+
+            for phase in phases:
+                succeeded, wall, rss = compile_main(
+                    args, header, expected, phase, MAX_OPS_LIMIT, MAX_LOOP_LIMIT, syntax_only=False)
+                if not succeeded:
+                    sys.exit(f"{num_nodes} nodes, phase {phase} needs more than the maximum limits")
+
+                ops = loop = "-"
+                if not args.no_limits:
+                    ops = min_limit(lambda limit: compile_main(
+                        args, header, expected, phase, limit, MAX_LOOP_LIMIT, syntax_only=True)[0],
+                        1, MAX_OPS_LIMIT, args.precision)
+                    loop = min_limit(lambda limit: compile_main(
+                        args, header, expected, phase, MAX_OPS_LIMIT, limit, syntax_only=True)[0],
+                        1, MAX_LOOP_LIMIT, args.precision)
+
+                print(f"{num_nodes:>8} {num_edges:>8} {PHASES[phase]:>10} {wall:>8.1f} {rss:>8.0f} "
+                      f"{ops:>14} {loop:>15}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
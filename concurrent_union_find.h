@@ -0,0 +1,235 @@
+#ifndef __CONCURRENT_UNION_FIND_H__
+#define __CONCURRENT_UNION_FIND_H__
+
+#include <array>
+#include <atomic>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "graph_raw.h"
+#include "parallel_parsing.h"
+#include "simd_parsing.h"
+#include "thread_pool.h"
+
+///
+/// @brief Lock free disjoint set that many threads can add edges to at once
+///
+/// The concurrent counterpart of disjoint_set_t, after Jayanti and Tarjan.
+/// Parents are atomics:
+///
+/// - find uses path splitting - every node on the path is pointed at its
+///   grandparent with a compare exchange.  A failed exchange just means
+///   another thread already shortened the path.
+/// - unite links the higher numbered root under the lower one with a
+///   compare exchange, and retries if the root stopped being a root.  Since
+///   links always go from higher to lower ids, there are no cycles.
+///
+/// Every successful link decrements the component count, so it's exact
+/// once the threads adding edges are done.  Run time only.
+///
+class concurrent_disjoint_set_t {
+  public:
+
+  using node_int_t = compact_id_int_t< dynamic_size >;
+
+  concurrent_disjoint_set_t() = delete;
+
+  /// @brief Create num_nodes sets, each containing a single node
+  explicit concurrent_disjoint_set_t( size_t num_nodes ) :
+    parent( num_nodes ), num_sets{ num_nodes }
+  {
+    if ( num_nodes >= std::numeric_limits< node_int_t >::max() ) {
+      throw std::out_of_range( "concurrent_disjoint_set_t: too many nodes" );
+    }
+    for ( size_t idx = 0; idx < num_nodes; ++idx ) {
+      parent[ idx ].store( static_cast< node_int_t >( idx ), std::memory_order_relaxed );
+    }
+  }
+
+  concurrent_disjoint_set_t( const concurrent_disjoint_set_t& ) = delete;
+  concurrent_disjoint_set_t& operator=( const concurrent_disjoint_set_t& ) = delete;
+
+  /// @brief Gets the number of nodes
+  size_t get_num_nodes() const {
+    return parent.size();
+  }
+
+  /// @brief Find the representative node of the set node is in
+  ///
+  /// Safe to call while other threads are adding edges; the answer is the
+  /// root at some point during the call.
+  ///
+  node_id_t find( node_id_t node ) {
+    if ( node.value() >= parent.size() ) {
+      throw std::out_of_range( "concurrent_disjoint_set_t: node out of range" );
+    }
+    node_int_t idx = static_cast< node_int_t >( node.value() );
+    while ( true ) {
+      node_int_t up = parent[ idx ].load( std::memory_order_relaxed );
+      const node_int_t grand_up = parent[ up ].load( std::memory_order_relaxed );
+      if ( up == grand_up ) {
+        return node_id_t{ up };
+      }
+      // Path splitting - point idx at its grandparent and move up
+      parent[ idx ].compare_exchange_weak( up, grand_up, std::memory_order_relaxed );
+      idx = up;
+    }
+  }
+
+  /// @brief Merge the sets containing node_a and node_b.  Thread safe.
+  ///
+  /// @return true if this call merged two sets
+  ///
+  bool unite( node_id_t node_a, node_id_t node_b ) {
+    while ( true ) {
+      node_int_t root_a = static_cast< node_int_t >( find( node_a ).value() );
+      node_int_t root_b = static_cast< node_int_t >( find( node_b ).value() );
+      if ( root_a == root_b ) {
+        return false;
+      }
+      if ( root_a < root_b ) {
+        std::swap( root_a, root_b );
+      }
+      // root_a is the higher id.  Hang it under root_b if it's still a root.
+      node_int_t expected = root_a;
+      if ( parent[ root_a ].compare_exchange_strong( expected, root_b, std::memory_order_acq_rel ) ) {
+        num_sets.fetch_sub( 1, std::memory_order_relaxed );
+        return true;
+      }
+    }
+  }
+
+  /// @brief Streaming ingestion.  Add a src -> dst edge.  Thread safe.
+  ///
+  /// Connectivity ignores direction, so this is unite.
+  ///
+  void add_edge( node_id_t src_node, node_id_t dst_node ) {
+    unite( src_node, dst_node );
+  }
+
+  /// @brief Gets the number of components
+  ///
+  /// Exact once every add_edge call has returned.
+  ///
+  size_t get_num_components() const {
+    return num_sets.load( std::memory_order_relaxed );
+  }
+
+  private:
+
+  std::vector< std::atomic< node_int_t > > parent;
+  std::atomic< size_t > num_sets;
+};
+
+///
+/// @brief Feed the edges of a graph text description into sets
+///
+/// @param text  The edge pairs - the graph text after the node count
+/// @param sets  The disjoint set to add the edges to
+/// @param pool  Threads to parse and ingest with.  The text is split into a
+///              chunk per thread.
+///
+/// Like parse_edges_parallel the text is split at newlines, but each
+/// thread adds its edges straight to the disjoint set as it parses them -
+/// there's no edge buffer and no adjacency.  An edge can be split over a
+/// newline, so a first pass counts each chunk's integers to find where
+/// the pairs start.  Edges split across chunks are added at the end.
+///
+inline void ingest_text_parallel( std::string_view text, concurrent_disjoint_set_t& sets, thread_pool_t& pool )
+{
+  const auto chunks = split_at_newlines( text, pool.size() );
+
+  // The integers at the ends of a chunk that it couldn't pair up itself
+  struct chunk_state_t {
+    size_t num_ints = 0;
+    bool starts_mid_edge = false;
+    std::optional< size_t > first_dst;  // dst of an edge from an earlier chunk
+    std::optional< size_t > last_src;   // src of an edge into a later chunk
+  };
+  std::vector< chunk_state_t > state( chunks.size() );
+
+  // Run func( chunk ) for every chunk on the pool.  Exceptions (i.e., node
+  // ids that are out of range) are passed on to the caller.
+  const auto for_each_chunk = [ & ]( auto func ) {
+    pool.parallel_for( 0, chunks.size(), [ & ]( size_t first, size_t last ) {
+      for ( size_t chunk = first; chunk < last; ++chunk ) {
+        func( chunk );
+      }
+    }, 1 );
+  };
+
+  // Pass 1: count the integers in each chunk
+  for_each_chunk( [ & ]( size_t chunk ) {
+    state[ chunk ].num_ints = count_tokens( chunks[ chunk ] );
+  });
+  size_t ints_before = 0;
+  for ( auto& chunk_state : state ) {
+    chunk_state.starts_mid_edge = ints_before % 2 == 1;
+    ints_before += chunk_state.num_ints;
+  }
+
+  // Pass 2: parse and add edges
+  for_each_chunk( [ & ]( size_t chunk ) {
+    chunk_state_t& chunk_state = state[ chunk ];
+    std::string_view remaining = chunks[ chunk ];
+    std::array< size_t, 512 > ints;
+    std::optional< size_t > src_node;
+    bool need_first_dst = chunk_state.starts_mid_edge;
+
+    read_whitespace( remaining );
+    while( remaining.size() > 0 ) {
+      const size_t num_ints = read_ints( remaining, ints );
+      for ( size_t idx = 0; idx < num_ints; ++idx ) {
+        if ( need_first_dst ) {
+          chunk_state.first_dst = ints[ idx ];
+          need_first_dst = false;
+        }
+        else if ( src_node.has_value() ) {
+          sets.add_edge( node_id_t{ *src_node }, node_id_t{ ints[ idx ] } );
+          src_node.reset();
+        }
+        else {
+          src_node = ints[ idx ];
+        }
+      }
+    }
+    chunk_state.last_src = src_node;
+  });
+
+  // Edges split across chunks.  As with read_int, a missing destination at
+  // the very end reads as 0.
+  bool have_src = false;
+  size_t src_node = 0;
+  for ( const auto& chunk_state : state ) {
+    if ( chunk_state.first_dst.has_value() ) {
+      sets.add_edge( node_id_t{ src_node }, node_id_t{ *chunk_state.first_dst } );
+      have_src = false;
+    }
+    if ( chunk_state.last_src.has_value() ) {
+      src_node = *chunk_state.last_src;
+      have_src = true;
+    }
+  }
+  if ( have_src ) {
+    sets.add_edge( node_id_t{ src_node }, node_id_t{ 0 } );
+  }
+}
+
+///
+/// @brief Count connected subgraphs by streaming the text into a
+///        concurrent_disjoint_set_t on pool's threads
+///
+inline int count_connected_concurrent( std::string_view text, thread_pool_t& pool )
+{
+  const auto num_nodes = read_int( text );
+  concurrent_disjoint_set_t sets{ num_nodes };
+  ingest_text_parallel( text, sets, pool );
+  return static_cast< int >( sets.get_num_components() );
+}
+
+#endif
+
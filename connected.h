@@ -0,0 +1,298 @@
+#ifndef __CONNECTED_H__
+#define __CONNECTED_H__
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "graph_raw.h"
+#include "bitset.h"
+#include "bit_parallel.h"
+
+///
+/// @brief Given a uni-directional graph, construct a bi-directional graph
+///
+/// Used to count connected subgraphs
+///
+/// Creates a bi-directional graph from a uni-directional graph by adding extra
+/// edges.  i.e.,  if there's an edge from A -> B in the input graph, the output
+/// graph is guaranteed to have both A -> B and B -> A.
+///
+template< typename graph_type >
+constexpr graph_type double_up_edges( const graph_type& graph )
+{
+  graph_type new_graph{ graph.get_num_nodes(), graph.get_num_edges() * 2 };
+
+  // For each nodes..
+  for( const auto& node : graph ) {
+    const auto node_idx = node.get_id();
+
+    // For each edge in the node
+    auto edge_itr = node.get_edge_head();
+    while( edge_itr.has_value() ) {
+      const auto& edge = graph.get_edge( edge_itr.value() );
+      const auto dst_node = edge.get_dst_node();
+
+      // Double up the edge in the new graph
+      new_graph.add_edge( node_idx, dst_node );
+      new_graph.add_edge( dst_node, node_idx );
+
+      edge_itr = edge.get_next_edge();
+    }
+  }
+  return new_graph;
+}
+
+/// @brief true for graphs whose neighbors() already list every edge at
+///        both ends, i.e., graph_undirected
+template< typename graph_type >
+inline constexpr bool is_undirected_graph_v = requires { requires graph_type::is_undirected; };
+
+///
+/// @brief Get a graph whose neighbors go both ways
+///
+/// A graph with is_undirected set, i.e., graph_undirected, already lists
+/// every edge at both ends, so it's returned as is, without a copy.  Any
+/// other graph gets double_up_edges.
+///
+template< typename graph_type >
+constexpr decltype( auto ) as_bidirectional( const graph_type& graph )
+{
+  if constexpr ( is_undirected_graph_v< graph_type > ) {
+    return ( graph );
+  }
+  else {
+    return double_up_edges( graph );
+  }
+}
+
+/// @brief One bit per node in graph_type, i.e., the visited set
+template< typename graph_type >
+using node_set_t = bitset_t< graph_type::max_num_nodes >;
+
+///
+/// @brief  Mark any nodes graph that are connected to node_idx
+///
+/// Used to count connected subgraphs
+///
+/// @param graph     - The graph we're connected the connected subgraphs of
+/// @param node_idx  - The node we're marking connectivity on
+/// @param visited   - The list of nodes that have already been visited
+/// @param frontier  - Scratch stack.  Empty on entry and exit; passing it in
+///                    lets callers reuse its allocation across calls.
+/// @param on_visit  - Called with each node as it's marked, node_idx first
+///
+/// The functions output is an updated visited array.
+///
+/// The search uses an explicit stack rather than recursion, so long chains
+/// of nodes don't need -fconstexpr-depth at compile time and can't
+/// overflow the native stack at run time.  Nodes are marked when they're
+/// pushed, so the stack only ever holds the frontier - nodes that have been
+/// found but whose edges haven't been followed yet.
+///
+template< typename graph_type, typename F >
+constexpr void mark_connected(
+  const graph_type& graph,
+  node_id_t node_idx,
+  node_set_t< graph_type > &visited,
+  std::vector< node_id_t > &frontier,
+  F on_visit
+)
+{
+  visited.set( node_idx.value() );
+  on_visit( node_idx );
+  frontier.push_back( node_idx );
+
+  while( !frontier.empty() ) {
+    const node_id_t src_node = frontier.back();
+    frontier.pop_back();
+
+    for( const node_id_t dst_node : graph.neighbors( src_node ) ) {
+      if ( !visited.test( dst_node.value() ) ) {
+        visited.set( dst_node.value() );
+        on_visit( dst_node );
+        frontier.push_back( dst_node );
+        // dst_node's neighbors are read soon - the next pop, if it's the
+        // last one found - so start loading its record now
+        if constexpr ( requires { graph.prefetch( dst_node ); } ) {
+          graph.prefetch( dst_node );
+        }
+      }
+    }
+  }
+}
+
+/// @brief mark_connected without a visitor
+template< typename graph_type >
+constexpr void mark_connected(
+  const graph_type& graph,
+  node_id_t node_idx,
+  node_set_t< graph_type > &visited,
+  std::vector< node_id_t > &frontier
+)
+{
+  mark_connected( graph, node_idx, visited, frontier, []( node_id_t ) {} );
+}
+
+/// @brief mark_connected with its own frontier stack
+template< typename graph_type >
+constexpr void mark_connected(
+  const graph_type& graph,
+  node_id_t node_idx,
+  node_set_t< graph_type > &visited
+)
+{
+  std::vector< node_id_t > frontier;
+  mark_connected( graph, node_idx, visited, frontier );
+}
+
+///
+/// @brief Count connected subgraphs of a graph with a depth first search
+///
+/// 1.  Make sure that all edges have a corresponding reverse edge
+/// 2.  Create a set of graph nodes we've visited
+/// 3.  Find the graph nodes that haven't been visited
+/// 4a. When an unvisited node is found, count it
+/// 4b. Then visit it and anything that connects to it
+///
+template< typename graph_type >
+constexpr int count_connected_dfs( const graph_type& graph )
+{
+  /// 1. Make sure that all edges have a corresponding reverse edge
+  ///    The doubled graph is usually a graph_type, but needn't be, i.e., a
+  ///    mapped_csr_t doubles up into a runtime_csr_t.  An undirected graph
+  ///    is used as it is.
+  const auto& bidir_graph = as_bidirectional( graph );
+
+  /// 2. Create a set of graph nodes we've visited.  Every node starts out
+  ///    unvisited.
+  node_set_t< graph_type > visited{ bidir_graph.get_num_nodes() };
+
+  /// 3. Find the graph nodes that haven't been visited.  The bitset skips
+  ///    over visited nodes a word at a time.
+  int subgraph_count = 0;
+  std::vector< node_id_t > frontier;
+  for ( size_t idx = visited.find_next_unset( 0 );
+        idx < bidir_graph.get_num_nodes();
+        idx = visited.find_next_unset( idx + 1 ) ) {
+    /// 4a. When an unvisited node is found, count it
+    ++subgraph_count;
+    /// 4b. Then visit it and anything that connects to it
+    mark_connected( bidir_graph, node_id_t{ idx }, visited, frontier );
+  }
+  return subgraph_count;
+}
+
+///
+/// @brief Count connected subgraphs of a graph
+///
+/// The algorithm is picked at compile time from the graph type's node
+/// limit.  Graphs with at most bit_parallel_max_nodes nodes fit in a couple
+/// of words per node, and count_connected_bit_parallel counts them without
+/// any allocation.  Anything bigger, or sized at run time, gets
+/// count_connected_dfs.
+///
+template< typename graph_type >
+constexpr int count_connected( const graph_type& graph )
+{
+  if constexpr ( graph_type::max_num_nodes <= bit_parallel_max_nodes ) {
+    return count_connected_bit_parallel( graph );
+  }
+  else {
+    return count_connected_dfs( graph );
+  }
+}
+
+///
+/// @brief The connected components of a graph, from connected_components
+///
+template< typename graph_type >
+struct components_t {
+  /// @brief Component ids are < the node count, so fit a compact id integer
+  using component_int_t = compact_id_int_t< graph_type::max_num_nodes >;
+
+  /// component[n] is the component node n is in.  Components are numbered
+  /// from 0 in the order they're found, which is the order of their lowest
+  /// numbered nodes.
+  typename graph_type::template node_data_t< component_int_t > component;
+  /// sizes[c] is the number of nodes in component c
+  std::vector< size_t > sizes;
+  /// The component with the most nodes.  The lowest numbered one on ties.
+  size_t largest = 0;
+  size_t num_components = 0;
+
+  /// @brief Gets ( size, number of components that size ) pairs, smallest
+  ///        size first
+  constexpr std::vector< std::pair< size_t, size_t > > size_histogram() const {
+    std::vector< size_t > sorted_sizes = sizes;
+    std::sort( sorted_sizes.begin(), sorted_sizes.end() );
+    std::vector< std::pair< size_t, size_t > > histogram;
+    for ( const size_t size : sorted_sizes ) {
+      if ( histogram.empty() || histogram.back().first != size ) {
+        histogram.emplace_back( size, 0 );
+      }
+      ++histogram.back().second;
+    }
+    return histogram;
+  }
+};
+
+///
+/// @brief Find the connected components of a graph
+///
+/// count_connected, but the traversal also labels each node with its
+/// component and counts the component's nodes, so the labels, sizes and
+/// largest component cost no extra passes.
+///
+template< typename graph_type >
+constexpr components_t< graph_type > connected_components( const graph_type& graph )
+{
+  using component_int_t = typename components_t< graph_type >::component_int_t;
+
+  const auto& bidir_graph = as_bidirectional( graph );
+  node_set_t< graph_type > visited{ bidir_graph.get_num_nodes() };
+
+  components_t< graph_type > result{ graph.template make_node_data< component_int_t >(), {}, 0, 0 };
+  std::vector< node_id_t > frontier;
+  for ( size_t idx = visited.find_next_unset( 0 );
+        idx < bidir_graph.get_num_nodes();
+        idx = visited.find_next_unset( idx + 1 ) ) {
+    const size_t component = result.num_components++;
+    size_t size = 0;
+    mark_connected( bidir_graph, node_id_t{ idx }, visited, frontier, [&]( node_id_t node ) {
+      result.component.at( node.value() ) = static_cast< component_int_t >( component );
+      ++size;
+    });
+    result.sizes.push_back( size );
+    if ( size > result.sizes.at( result.largest ) ) {
+      result.largest = component;
+    }
+  }
+  return result;
+}
+
+#ifndef NO_HEADER_TESTS
+static_assert( []() {
+  const auto components = connected_components(
+    read_graph< graph_raw< 7, 8 > >( "7 0 1 5 6 2 1 4 4" ) );
+  const auto histogram = components.size_histogram();
+  return components.num_components == 4
+    && components.component[ 2 ] == 0 && components.component[ 3 ] == 1
+    && components.component[ 4 ] == 2 && components.component[ 6 ] == 3
+    && components.sizes == std::vector< size_t >{ 3, 1, 1, 2 }
+    && components.largest == 0
+    && histogram == std::vector< std::pair< size_t, size_t > >{ { 1, 2 }, { 2, 1 }, { 3, 1 } };
+}() );
+
+// A chain deeper than gcc's default -fconstexpr-depth of 512
+static_assert( []() {
+  graph_raw< 2000, 4000 > chain{ 2000 };
+  for ( size_t idx = 1; idx < 2000; ++idx ) {
+    chain.add_edge( node_id_t{ idx - 1 }, node_id_t{ idx } );
+  }
+  return count_connected( chain ) == 1;
+}() );
+#endif
+
+#endif
+
@@ -0,0 +1,176 @@
+#ifndef __CONNECTIVITY_QUERY_H__
+#define __CONNECTIVITY_QUERY_H__
+
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "connected.h"
+#include "simd_parsing.h"
+
+/// @brief A pair of nodes to ask connectivity_query_t::connected about
+struct node_pair_t {
+  node_id_t node_a;
+  node_id_t node_b;
+};
+
+///
+/// @brief Answers "are a and b connected?" in O(1)
+///
+/// Built from a graph with one connected_components pass; after that a
+/// query is two label loads and a compare.  Only the labels are kept, so
+/// for graphs with compile time limits the query object can be a constexpr
+/// variable, and static_asserts about it cost nothing more to evaluate.
+///
+template< typename graph_type >
+class connectivity_query_t {
+  public:
+
+  using component_int_t = typename components_t< graph_type >::component_int_t;
+
+  connectivity_query_t() = delete;
+
+  /// @brief Label the components of graph
+  constexpr explicit connectivity_query_t( const graph_type& graph ) :
+    connectivity_query_t{ connected_components( graph ) } {}
+
+  /// @brief Use components that are already labeled
+  constexpr explicit connectivity_query_t( components_t< graph_type > components ) :
+    component{ std::move( components.component ) },
+    num_nodes{ count_nodes( components.sizes ) },
+    num_components{ components.num_components } {}
+
+  /// @brief Gets the component node is in.  See components_t.
+  ///
+  /// Throws std::out_of_range for a node that isn't in the graph.  With
+  /// compile time limits, component has room for more nodes than that.
+  ///
+  constexpr size_t component_of( node_id_t node ) const {
+    if ( node.value() >= num_nodes ) {
+      throw std::out_of_range( "connectivity_query_t: node out of range" );
+    }
+    return component[ node.value() ];
+  }
+
+  /// @brief true if there is a path between node_a and node_b, ignoring
+  ///        edge direction
+  constexpr bool connected( node_id_t node_a, node_id_t node_b ) const {
+    return component_of( node_a ) == component_of( node_b );
+  }
+
+  ///
+  /// @brief Answer a batch of queries
+  ///
+  /// @param queries  Pairs of nodes
+  /// @param answers  answers[i] is set to connected( queries[i] ).  Must be
+  ///                 at least as big as queries.
+  ///
+  /// At run time, with 32 bit labels and AVX2, the labels are fetched with
+  /// gathers, four pairs at a time.  Throws std::out_of_range for a node
+  /// that isn't in the graph, like connected does.
+  ///
+  constexpr void connected( std::span< const node_pair_t > queries, std::span< bool > answers ) const {
+    if ( answers.size() < queries.size() ) {
+      throw std::out_of_range( "connectivity_query_t: answers is smaller than queries" );
+    }
+    size_t idx = 0;
+#ifdef SIMD_PARSING_X86
+    if constexpr ( sizeof( component_int_t ) == sizeof( int ) ) {
+      if ( !std::is_constant_evaluated() && simd_parsing_detail::cpu_has_avx2() ) {
+        idx = connected_avx2( queries, answers );
+      }
+    }
+#endif
+    for ( ; idx < queries.size(); ++idx ) {
+      answers[ idx ] = connected( queries[ idx ].node_a, queries[ idx ].node_b );
+    }
+  }
+
+  /// @brief Gets the number of connected components
+  constexpr size_t get_num_components() const {
+    return num_components;
+  }
+
+  private:
+
+  // Every node is in one component.  Unlike component.size(), this is the
+  // number of used nodes for graphs with compile time limits too.
+  static constexpr size_t count_nodes( const std::vector< size_t >& sizes ) {
+    size_t total = 0;
+    for ( const size_t size : sizes ) {
+      total += size;
+    }
+    return total;
+  }
+
+#ifdef SIMD_PARSING_X86
+  /// Answers queries four at a time, and returns how many were answered.
+  /// Stops at the first block with a node out of range, so the scalar loop
+  /// throws for it.
+  [[gnu::target("avx2")]]
+  size_t connected_avx2( std::span< const node_pair_t > queries, std::span< bool > answers ) const {
+    static_assert( sizeof( node_pair_t ) == 2 * sizeof( long long ) );
+    const int* labels = reinterpret_cast< const int* >( component.data() );
+    // Unsigned compare of 64 bit ids, by flipping the sign bits
+    const __m256i sign = _mm256_set1_epi64x( static_cast< long long >( 1ull << 63 ) );
+    const __m256i limit = _mm256_xor_si256( _mm256_set1_epi64x( static_cast< long long >( num_nodes ) ), sign );
+
+    size_t idx = 0;
+    for ( ; idx + 4 <= queries.size(); idx += 4 ) {
+      // [ a0 b0 a1 b1 ] and [ a2 b2 a3 b3 ]
+      const auto* ids = reinterpret_cast< const __m256i* >( queries.data() + idx );
+      const __m256i ids_01 = _mm256_loadu_si256( ids );
+      const __m256i ids_23 = _mm256_loadu_si256( ids + 1 );
+      const __m256i in_range = _mm256_and_si256(
+        _mm256_cmpgt_epi64( limit, _mm256_xor_si256( ids_01, sign ) ),
+        _mm256_cmpgt_epi64( limit, _mm256_xor_si256( ids_23, sign ) ) );
+      if ( _mm256_movemask_epi8( in_range ) != -1 ) {
+        break;
+      }
+
+      // [ la0 lb0 la1 lb1 la2 lb2 la3 lb3 ], compared with itself with each
+      // a and b swapped
+      const __m256i pair_labels = _mm256_set_m128i(
+        _mm256_i64gather_epi32( labels, ids_23, sizeof( int ) ),
+        _mm256_i64gather_epi32( labels, ids_01, sizeof( int ) ) );
+      const __m256i swapped = _mm256_shuffle_epi32( pair_labels, 0xb1 );
+      const int equal = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( pair_labels, swapped ) ) );
+      for ( size_t pair = 0; pair < 4; ++pair ) {
+        answers[ idx + pair ] = ( equal >> ( pair * 2 ) ) & 1;
+      }
+    }
+    return idx;
+  }
+#endif
+
+  typename graph_type::template node_data_t< component_int_t > component;
+  size_t num_nodes;
+  size_t num_components;
+};
+
+#ifndef NO_HEADER_TESTS
+// Fewer nodes than the graph type has room for, so nodes 6 and 7 aren't
+// in any component.  Components are numbered by their lowest node, and the
+// batch isn't a whole number of the four pairs connected_avx2 answers at
+// once.  Answers past the queries are left alone.
+static_assert( []() {
+  const connectivity_query_t query{ read_graph< graph_raw< 8, 8 > >( "6 5 0 3 3 2 4" ) };
+  const node_pair_t queries[] = {
+    { node_id_t{ 0 }, node_id_t{ 5 } }, { node_id_t{ 5 }, node_id_t{ 0 } }, { node_id_t{ 1 }, node_id_t{ 1 } },
+    { node_id_t{ 3 }, node_id_t{ 2 } }, { node_id_t{ 4 }, node_id_t{ 2 } }, { node_id_t{ 0 }, node_id_t{ 1 } }
+  };
+  bool answers[ 7 ] = {};
+  answers[ 6 ] = true;
+  query.connected( queries, answers );
+  return query.get_num_components() == 4
+    && query.component_of( node_id_t{ 5 } ) == 0 && query.component_of( node_id_t{ 4 } ) == 2
+    && query.component_of( node_id_t{ 3 } ) == 3
+    && answers[ 0 ] && answers[ 1 ] && answers[ 2 ] && !answers[ 3 ] && answers[ 4 ] && !answers[ 5 ]
+    && answers[ 6 ];
+}() );
+#endif
+
+#endif
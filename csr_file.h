@@ -0,0 +1,322 @@
+#ifndef __CSR_FILE_H__
+#define __CSR_FILE_H__
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "graph_csr.h"
+#include "mapped_file.h"
+
+/// @brief Binary CSR graph files.
+///
+/// Parsing the text every run is wasted work once a graph is stable.  A CSR
+/// file holds the arrays of a runtime_csr_t exactly as they are in memory,
+/// so loading one is an mmap and a check of the header and arrays - the
+/// algorithms run on the mapped arrays, with nothing copied.
+///
+/// Layout, all integers native endian:
+///
+///   csr_file_header_t
+///   offsets       num_nodes + 1 uint32s, at header.offsets_position
+///   neighbor ids  num_edges uint32s, at header.neighbors_position
+///
+/// Both arrays start on a csr_file_alignment boundary.
+
+/// @brief Arrays in a CSR file start on multiples of this many bytes
+inline constexpr size_t csr_file_alignment = 64;
+
+/// @brief The first bytes of every CSR file
+inline constexpr char csr_file_magic[ 8 ] = { 'S', 'S', 'C', 'S', 'R', 'G', 'R', 'F' };
+
+/// @brief The CSR file version written by write_csr_file
+inline constexpr uint32_t csr_file_version = 1;
+
+///
+/// @brief The header at the start of a CSR file
+///
+struct csr_file_header_t {
+  char magic[ 8 ];
+  /// Bumped when the layout changes
+  uint32_t version;
+  /// Written as 0x01020304, so a file from a machine with the other byte
+  /// order is caught instead of misread
+  uint32_t byte_order;
+  /// Bytes per offset and per neighbor id.  Always 4 in version 1.
+  uint32_t id_bytes;
+  uint64_t num_nodes;
+  uint64_t num_edges;
+  /// Where the arrays start, in bytes from the start of the file
+  uint64_t offsets_position;
+  uint64_t neighbors_position;
+};
+
+static_assert( std::is_trivially_copyable_v< csr_file_header_t > );
+static_assert( sizeof( csr_file_header_t ) <= csr_file_alignment );
+
+// The mapped arrays are used in place as runtime_csr_t's arrays
+static_assert( sizeof( runtime_csr_t::offset_t ) == 4 );
+static_assert( sizeof( runtime_csr_t::stored_node_id_t ) == 4 );
+static_assert( std::is_trivially_copyable_v< runtime_csr_t::stored_node_id_t > );
+
+/// @brief true if data starts like a CSR file, i.e., isn't graph text
+inline bool is_csr_file( std::string_view data )
+{
+  return data.size() >= sizeof( csr_file_magic )
+    && std::memcmp( data.data(), csr_file_magic, sizeof( csr_file_magic ) ) == 0;
+}
+
+///
+/// @brief Write a CSR graph to a CSR file
+///
+/// @param graph  The graph.  Any graph_csr works - ids are written as 32 bits.
+/// @param path   The file to write
+///
+/// Throws std::runtime_error if the file can't be written, and
+/// std::out_of_range if a neighbor id is past the last node or an offset
+/// or id doesn't fit in 32 bits.
+///
+template< typename csr_type >
+void write_csr_file( const csr_type& graph, const char* path )
+{
+  const auto align = []( uint64_t position ) {
+    return ( position + csr_file_alignment - 1 ) / csr_file_alignment * csr_file_alignment;
+  };
+
+  // Check before anything is written, so a bad graph doesn't leave a
+  // truncated file behind.  Offsets are at most num_edges and ids are less
+  // than num_nodes, so every value put below fits in 32 bits.
+  if ( graph.get_num_nodes() > std::numeric_limits< uint32_t >::max()
+    || graph.get_num_edges() > std::numeric_limits< uint32_t >::max() ) {
+    throw std::out_of_range( "write_csr_file: graph too big for 32 bit ids" );
+  }
+  graph.for_each_edge( [ & ]( node_id_t, node_id_t dst_node ) {
+    if ( dst_node.value() >= graph.get_num_nodes() ) {
+      throw std::out_of_range( "write_csr_file: neighbor id out of range" );
+    }
+  });
+
+  csr_file_header_t header{};
+  std::memcpy( header.magic, csr_file_magic, sizeof( header.magic ) );
+  header.version = csr_file_version;
+  header.byte_order = 0x01020304;
+  header.id_bytes = sizeof( uint32_t );
+  header.num_nodes = graph.get_num_nodes();
+  header.num_edges = graph.get_num_edges();
+  header.offsets_position = align( sizeof( header ) );
+  header.neighbors_position = align( header.offsets_position + ( header.num_nodes + 1 ) * sizeof( uint32_t ) );
+
+  std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+  const auto write = [ & ]( const void* data, size_t size ) {
+    file.write( static_cast< const char* >( data ), static_cast< std::streamsize >( size ) );
+  };
+  const auto pad_to = [ & ]( uint64_t position ) {
+    const char zeros[ csr_file_alignment ] = {};
+    write( zeros, position - static_cast< uint64_t >( file.tellp() ) );
+  };
+
+  write( &header, sizeof( header ) );
+
+  // Offsets and ids are converted to 32 bits a buffer at a time
+  std::vector< uint32_t > buffer;
+  const auto flush = [ & ]() {
+    write( buffer.data(), buffer.size() * sizeof( uint32_t ) );
+    buffer.clear();
+  };
+  const auto put = [ & ]( size_t value ) {
+    buffer.push_back( static_cast< uint32_t >( value ) );
+    if ( buffer.size() == 4096 ) {
+      flush();
+    }
+  };
+
+  pad_to( header.offsets_position );
+  size_t offset = 0;
+  put( offset );
+  for ( size_t idx = 0; idx < graph.get_num_nodes(); ++idx ) {
+    offset += graph.neighbors( node_id_t{ idx } ).size();
+    put( offset );
+  }
+  flush();
+
+  pad_to( header.neighbors_position );
+  graph.for_each_edge( [ & ]( node_id_t, node_id_t dst_node ) {
+    put( dst_node.value() );
+  });
+  flush();
+
+  if ( !file.flush() ) {
+    throw std::runtime_error( std::string( "write " ) + path + " failed" );
+  }
+}
+
+/// @brief How much of a CSR file mapped_csr_t checks when it's loaded
+enum class csr_check_t {
+  /// The header and the first and last offsets.  O(1), so loading doesn't
+  /// touch the arrays.  Offsets or ids that are corrupt in between can
+  /// send a traversal out of bounds, so this is for files written by
+  /// write_csr_file.
+  header,
+  /// Also every offset and neighbor id, reading the whole file once.  For
+  /// files from anywhere else.
+  full
+};
+
+///
+/// @brief A CSR graph mapped straight from a CSR file
+///
+/// Has the same interface as runtime_csr_t - neighbors, for_each_edge and
+/// so on - so count_connected, count_connected_union_find and
+/// count_connected_afforest all run on it.  Nothing is copied, and by
+/// default loading only reads the header.  See csr_check_t.
+///
+/// Throws std::system_error if the file can't be mapped, and
+/// std::runtime_error if it isn't a valid CSR file.
+///
+class mapped_csr_t {
+  public:
+
+  static constexpr size_t max_num_nodes = runtime_csr_t::max_num_nodes;
+  using stored_node_id_t = runtime_csr_t::stored_node_id_t;
+  using offset_t = runtime_csr_t::offset_t;
+
+  template< typename T >
+  using node_data_t = runtime_csr_t::node_data_t< T >;
+
+  mapped_csr_t() = delete;
+
+  /// @brief Map the CSR file at path
+  explicit mapped_csr_t( const char* path, csr_check_t check = csr_check_t::header ) :
+    mapped_csr_t{ mapped_file_t{ path }, check } {}
+
+  /// @brief Use a file that's already mapped, i.e., after is_csr_file
+  ///
+  /// A full check reads the file front to back, so the mapping can start
+  /// out MADV_SEQUENTIAL.  Once the checks pass it's advised MADV_NORMAL,
+  /// since the engines read neighbors in whatever order they find nodes.
+  ///
+  explicit mapped_csr_t( mapped_file_t file_arg, csr_check_t check = csr_check_t::header ) :
+    file{ std::move( file_arg ) } {
+    const std::string_view data = file.view();
+    const auto fail = [ & ]( const char* why ) {
+      throw std::runtime_error( why );
+    };
+
+    if ( !is_csr_file( data ) || data.size() < sizeof( csr_file_header_t ) ) {
+      fail( "not a CSR file" );
+    }
+    csr_file_header_t header;
+    std::memcpy( &header, data.data(), sizeof( header ) );
+    if ( header.version != csr_file_version ) {
+      fail( "unsupported CSR file version" );
+    }
+    if ( header.byte_order != 0x01020304 || header.id_bytes != sizeof( uint32_t ) ) {
+      fail( "CSR file is from a different kind of machine" );
+    }
+    if ( header.num_nodes >= data.size() || header.num_edges >= data.size()
+      || header.offsets_position % csr_file_alignment != 0
+      || header.neighbors_position % csr_file_alignment != 0
+      || header.offsets_position + ( header.num_nodes + 1 ) * sizeof( offset_t ) > data.size()
+      || header.neighbors_position + header.num_edges * sizeof( stored_node_id_t ) > data.size() ) {
+      fail( "truncated CSR file" );
+    }
+
+    offsets = { reinterpret_cast< const offset_t* >( data.data() + header.offsets_position ),
+                header.num_nodes + 1 };
+    neighbor_ids = { reinterpret_cast< const stored_node_id_t* >( data.data() + header.neighbors_position ),
+                     header.num_edges };
+    if ( offsets.front() != 0 || offsets.back() != header.num_edges ) {
+      fail( "corrupt CSR file" );
+    }
+    if ( check == csr_check_t::full ) {
+      check_arrays();
+    }
+    file.advise( MADV_NORMAL );
+  }
+
+  /// @brief Gets the number of nodes in the graph
+  size_t get_num_nodes() const {
+    return offsets.size() - 1;
+  }
+
+  /// @brief Gets the number of edges in the graph
+  size_t get_num_edges() const {
+    return neighbor_ids.size();
+  }
+
+  /// @brief Create per node data, value initialized, for every used node
+  template< typename T >
+  node_data_t< T > make_node_data() const {
+    return make_sized_array< T, max_num_nodes >( get_num_nodes() );
+  }
+
+  /// @brief Gets the destination nodes of every edge leaving node_idx
+  std::span< const stored_node_id_t > neighbors( node_id_t node_idx ) const {
+    const size_t first = offsets[ node_idx.value() ];
+    const size_t last = offsets[ node_idx.value() + 1 ];
+    return neighbor_ids.subspan( first, last - first );
+  }
+
+  /// @brief Hint that node_idx's neighbors will be read soon.  Only its
+  ///        offset is prefetched, like graph_csr::prefetch.
+  void prefetch( node_id_t node_idx ) const {
+    __builtin_prefetch( offsets.data() + node_idx.value() );
+  }
+
+  /// @brief Call func( src, dst ) for every edge in the graph
+  template< typename F >
+  void for_each_edge( F func ) const {
+    for ( size_t idx = 0; idx < get_num_nodes(); ++idx ) {
+      for ( const node_id_t dst_node : neighbors( node_id_t{ idx } ) ) {
+        func( node_id_t{ idx }, dst_node );
+      }
+    }
+  }
+
+  private:
+
+  // Every neighbors() span has to be inside neighbor_ids, and every id a
+  // node, or the engines would read and write past their arrays.  O(N + E).
+  void check_arrays() const {
+    for ( size_t idx = 0; idx < get_num_nodes(); ++idx ) {
+      if ( offsets[ idx ] > offsets[ idx + 1 ] ) {
+        throw std::runtime_error( "corrupt CSR file: offsets go backwards" );
+      }
+    }
+    for ( const stored_node_id_t dst_node : neighbor_ids ) {
+      if ( dst_node.value() >= get_num_nodes() ) {
+        throw std::runtime_error( "corrupt CSR file: neighbor id out of range" );
+      }
+    }
+  }
+
+  mapped_file_t file;
+  std::span< const offset_t > offsets;
+  std::span< const stored_node_id_t > neighbor_ids;
+};
+
+///
+/// @brief Given a mapped uni-directional CSR graph, construct a
+///        bi-directional runtime_csr_t.  Used by count_connected.
+///
+inline runtime_csr_t double_up_edges( const mapped_csr_t& graph )
+{
+  return { graph.get_num_nodes(), graph.get_num_edges() * 2, [&graph]( auto add_edge ) {
+    graph.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+      add_edge( src_node, dst_node );
+      add_edge( dst_node, src_node );
+    });
+  }};
+}
+
+#endif
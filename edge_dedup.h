@@ -0,0 +1,184 @@
+#ifndef __EDGE_DEDUP_H__
+#define __EDGE_DEDUP_H__
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "graph_raw.h"
+#include "text_parsing.h"
+
+///
+/// @brief The edges of a graph with duplicates and self loops removed
+///
+/// Connectivity ignores edge direction, so A -> B and B -> A are the same
+/// edge.  Every edge is stored once, as lower node -> higher node, sorted.
+/// After double_up_edges that's exactly two stored edges per connection
+/// instead of up to four.
+///
+struct deduped_edges_t {
+  size_t num_nodes = 0;
+  /// Each edge as low * num_nodes + high, sorted and unique
+  std::vector< uint64_t > keys;
+  /// Number of input edges that were dropped as duplicates or self loops
+  size_t num_dropped = 0;
+
+  /// @brief Gets the number of edges left
+  constexpr size_t get_num_edges() const {
+    return keys.size();
+  }
+
+  /// @brief Call func( src, dst ) for each edge left, src < dst, in order
+  template< typename F >
+  constexpr void for_each_edge( F func ) const {
+    for ( const uint64_t key : keys ) {
+      func( node_id_t{ key / num_nodes }, node_id_t{ key % num_nodes } );
+    }
+  }
+};
+
+namespace edge_dedup_detail {
+
+///
+/// @brief Sort keys with an LSD radix sort, 16 bits per pass
+///
+/// Only the passes that max_key needs are done - with n nodes the keys are
+/// < n^2, so a 10 million node graph takes 3 passes, not 4.
+///
+inline void radix_sort( std::vector< uint64_t >& keys, uint64_t max_key )
+{
+  constexpr unsigned bits_per_pass = 16;
+  constexpr size_t num_buckets = size_t{ 1 } << bits_per_pass;
+
+  std::vector< uint64_t > scratch( keys.size() );
+  std::vector< size_t > bucket_start( num_buckets );
+  const unsigned key_bits = static_cast< unsigned >( std::bit_width( max_key ) );
+
+  for ( unsigned shift = 0; shift < key_bits; shift += bits_per_pass ) {
+    std::fill( bucket_start.begin(), bucket_start.end(), 0 );
+    for ( const uint64_t key : keys ) {
+      ++bucket_start[ ( key >> shift ) & ( num_buckets - 1 ) ];
+    }
+    size_t start = 0;
+    for ( size_t& bucket : bucket_start ) {
+      start += std::exchange( bucket, start );
+    }
+    for ( const uint64_t key : keys ) {
+      scratch[ bucket_start[ ( key >> shift ) & ( num_buckets - 1 ) ]++ ] = key;
+    }
+    keys.swap( scratch );
+  }
+}
+
+}
+
+///
+/// @brief Drop duplicate edges and self loops from a list of edges
+///
+/// @param num_nodes      Number of nodes in the graph
+/// @param edge_capacity  How many edges to reserve room for
+/// @param for_each_edge  Called with an add_edge( src, dst ) callback,
+///                       which it calls once for every edge
+///
+/// The edges are sorted before the duplicates are removed - with a radix
+/// sort at run time, and std::sort in constant evaluation.
+///
+/// Throws std::out_of_range for an edge with a node >= num_nodes, or if
+/// num_nodes doesn't fit in 32 bits - an edge's key is
+/// low * num_nodes + high, which has to fit in 64.
+///
+template< typename F >
+constexpr deduped_edges_t dedup_edges( size_t num_nodes, size_t edge_capacity, F for_each_edge )
+{
+  if ( num_nodes > std::numeric_limits< uint32_t >::max() ) {
+    throw std::out_of_range( "dedup_edges: too many nodes for 64 bit edge keys" );
+  }
+
+  deduped_edges_t result;
+  result.num_nodes = num_nodes;
+  result.keys.reserve( edge_capacity );
+
+  size_t num_edges = 0;
+  for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+    ++num_edges;
+    if ( src_node.value() >= result.num_nodes || dst_node.value() >= result.num_nodes ) {
+      throw std::out_of_range( "dedup_edges: node out of range" );
+    }
+    if ( src_node == dst_node ) {
+      return;
+    }
+    const uint64_t low = std::min( src_node.value(), dst_node.value() );
+    const uint64_t high = std::max( src_node.value(), dst_node.value() );
+    result.keys.push_back( low * result.num_nodes + high );
+  });
+
+  if ( std::is_constant_evaluated() ) {
+    std::sort( result.keys.begin(), result.keys.end() );
+  }
+  else {
+    const uint64_t key_limit = result.num_nodes;
+    edge_dedup_detail::radix_sort( result.keys, key_limit * key_limit );
+  }
+  result.keys.erase( std::unique( result.keys.begin(), result.keys.end() ), result.keys.end() );
+  result.num_dropped = num_edges - result.keys.size();
+  return result;
+}
+
+///
+/// @brief Parse a graph text description, dropping duplicate edges and
+///        self loops
+///
+/// @param text  The graph description, same format as read_graph
+///
+constexpr deduped_edges_t dedup_text_edges( std::string_view text )
+{
+  const size_t num_nodes = read_int( text );
+  return dedup_edges( num_nodes, count_text_edges( text ), [text]( auto add_edge ) {
+    for_each_text_edge( text, add_edge );
+  });
+}
+
+///
+/// @brief Create a graph from deduplicated edges
+///
+/// graph_type is a graph_raw or graph_csr.  Only get_num_edges() edges of
+/// capacity are needed.
+///
+template< typename graph_type >
+constexpr graph_type make_graph( const deduped_edges_t& edges )
+{
+  if constexpr ( requires { graph_type{ 0, 0, []( auto ) {} }; } ) {
+    // graph_csr - built from an edge enumerator
+    return graph_type{ edges.num_nodes, edges.get_num_edges(), [&edges]( auto add_edge ) {
+      edges.for_each_edge( add_edge );
+    }};
+  }
+  else {
+    graph_type graph{ edges.num_nodes, edges.get_num_edges() };
+    edges.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+      graph.add_edge( src_node, dst_node );
+    });
+    return graph;
+  }
+}
+
+#ifndef NO_HEADER_TESTS
+static_assert( []() {
+  const deduped_edges_t edges = dedup_text_edges( "4 2 1 1 2 3 3 0 1 2 1 0 3" );
+  std::vector< size_t > ends;
+  edges.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+    ends.push_back( src_node.value() * 10 + dst_node.value() );
+  });
+  return edges.num_dropped == 3 && ends == std::vector< size_t >{ 1, 3, 12 };
+}() );
+
+static_assert( make_graph< graph_raw< 3, 1 > >( dedup_text_edges( "3 0 1 1 0 0 1" ) ).get_num_edges() == 1 );
+#endif
+
+#endif
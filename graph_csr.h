@@ -0,0 +1,265 @@
+#ifndef __GRAPH_CSR_H__
+#define __GRAPH_CSR_H__
+
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "graph_raw.h"
+#include "sized_storage.h"
+#include "text_parsing.h"
+
+///
+/// @brief Graph in compressed sparse row (CSR) form
+///
+/// Every node's neighbors are packed together in one array, in node order.
+/// offsets[n] is where node n's neighbors start and offsets[n+1] is where
+/// they end, so a neighbor scan is a sequential read instead of a walk
+/// down a linked list of edges.
+///
+/// The graph is immutable once built.  Use read_graph_csr or make_csr to
+/// create one.  Like graph_raw, max_nodes and max_edges may be dynamic_size.
+///
+template< size_t max_nodes, size_t max_edges >
+class graph_csr {
+  public:
+
+  /// @brief The node limit the graph was instantiated with
+  static constexpr size_t max_num_nodes = max_nodes;
+
+  /// @brief offsets has one more entry than there are nodes
+  static constexpr size_t max_offsets = max_nodes == dynamic_size ? dynamic_size : max_nodes + 1;
+
+  /// @brief Neighbors and offsets are stored in the smallest integers that fit
+  using stored_node_id_t = compact_node_id_t< max_nodes >;
+  using offset_t = compact_id_int_t< max_edges >;
+
+  /// @brief Per node data, i.e., a visited flag for each node
+  template< typename T >
+  using node_data_t = sized_array_t< T, max_nodes >;
+
+  graph_csr() = delete;
+
+  ///
+  /// @brief Build a graph from an edge enumerator
+  ///
+  /// @param num_nodes_arg  - Number of nodes in the graph
+  /// @param edge_capacity  - Number of edges the graph can hold
+  /// @param for_each_edge  - Called with an add_edge( src, dst ) callback,
+  ///                         which it calls once for every edge.  It's
+  ///                         called twice - once for the counting pass and
+  ///                         once for the fill pass - and must produce the
+  ///                         same edges both times.
+  ///
+  /// Throws std::out_of_range for an edge with a node >= num_nodes_arg.
+  ///
+  template< typename F >
+  constexpr graph_csr( size_t num_nodes_arg, size_t edge_capacity, F for_each_edge ) :
+    used_nodes{ num_nodes_arg },
+    offsets{ make_sized_array< offset_t, max_offsets >( num_nodes_arg + 1 ) },
+    neighbor_ids{ make_sized_array< stored_node_id_t, max_edges >( edge_capacity ) }
+  {
+    if ( edge_capacity > std::numeric_limits< offset_t >::max() ) {
+      throw std::out_of_range( "graph_csr: too many edges for offset_t" );
+    }
+
+    // Counting pass.  offsets[ src + 1 ] becomes src's out degree
+    for_each_edge( [&]( node_id_t src_node, node_id_t ) {
+      if ( src_node.value() >= used_nodes ) {
+        throw std::out_of_range( "graph_csr: node out of range" );
+      }
+      ++offsets.at( src_node.value() + 1 );
+    });
+
+    // Prefix sum.  offsets[ src ] becomes the start of src's neighbors.
+    for ( size_t idx = 1; idx <= used_nodes; ++idx ) {
+      offsets.at( idx ) += offsets.at( idx - 1 );
+    }
+
+    // Fill pass.  offsets[ src ] is used as src's write cursor, so when the
+    // pass is done it has moved to where src + 1's neighbors start.
+    for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+      if ( dst_node.value() >= used_nodes ) {
+        throw std::out_of_range( "graph_csr: node out of range" );
+      }
+      neighbor_ids.at( offsets.at( src_node.value() )++ ) = stored_node_id_t{ dst_node };
+    });
+
+    // Shift the cursors back to get the start of each node's neighbors
+    for ( size_t idx = used_nodes; idx > 0; --idx ) {
+      offsets.at( idx ) = offsets.at( idx - 1 );
+    }
+    offsets.at( 0 ) = 0;
+  }
+
+  ///
+  /// @brief Take over arrays that are already in CSR form, i.e., from
+  ///        make_csr_parallel.  Run time sized graphs only.
+  ///
+  /// @param offsets_arg    - One more offset than there are nodes.  The
+  ///                         last one is the number of edges.
+  /// @param neighbors_arg  - Every node's neighbors, packed in node order
+  ///
+  constexpr graph_csr(
+    sized_array_t< offset_t, max_offsets > offsets_arg,
+    sized_array_t< stored_node_id_t, max_edges > neighbors_arg
+  ) requires ( max_nodes == dynamic_size && max_edges == dynamic_size ) :
+    used_nodes{ offsets_arg.size() - 1 },
+    offsets{ std::move( offsets_arg ) },
+    neighbor_ids{ std::move( neighbors_arg ) }
+  {
+    if ( offsets.empty() || offsets.back() > neighbor_ids.size() ) {
+      throw std::invalid_argument( "graph_csr: offsets don't match the neighbors" );
+    }
+  }
+
+  /// @brief Gets the number of nodes in the graph
+  constexpr size_t get_num_nodes() const {
+    return used_nodes;
+  }
+
+  /// @brief Gets the number of edges in the graph
+  constexpr size_t get_num_edges() const {
+    return offsets.at( used_nodes );
+  }
+
+  /// @brief Create per node data, value initialized, for every used node
+  template< typename T >
+  constexpr node_data_t< T > make_node_data() const {
+    return make_sized_array< T, max_nodes >( used_nodes );
+  }
+
+  /// @brief Gets the destination nodes of every edge leaving node_idx
+  ///
+  /// The neighbors are contiguous in memory.
+  ///
+  constexpr std::span< const stored_node_id_t > neighbors( node_id_t node_idx ) const {
+    const size_t first = offsets.at( node_idx.value() );
+    const size_t last = offsets.at( node_idx.value() + 1 );
+    return { neighbor_ids.data() + first, last - first };
+  }
+
+  /// @brief Hint that node_idx's neighbors will be read soon.  A no-op in
+  ///        constant evaluation.
+  ///
+  /// Only node_idx's offset is prefetched, not the neighbors it points at.
+  ///
+  constexpr void prefetch( node_id_t node_idx ) const {
+    if ( !std::is_constant_evaluated() ) {
+      __builtin_prefetch( offsets.data() + node_idx.value() );
+    }
+  }
+
+  /// @brief Call func( src, dst ) for every edge in the graph
+  template< typename F >
+  constexpr void for_each_edge( F func ) const {
+    for ( size_t idx = 0; idx < used_nodes; ++idx ) {
+      for ( const node_id_t dst_node : neighbors( node_id_t{ idx } ) ) {
+        func( node_id_t{ idx }, dst_node );
+      }
+    }
+  }
+
+  private:
+
+  size_t used_nodes;
+  sized_array_t< offset_t, max_offsets > offsets;
+  sized_array_t< stored_node_id_t, max_edges > neighbor_ids;
+};
+
+///
+/// @brief Given a graph text description, create a CSR graph
+///
+/// Same text format as read_graph.  The text is parsed twice, once to
+/// count each node's edges and once to fill in the neighbors.
+///
+template< typename csr_type >
+constexpr csr_type read_graph_csr( std::string_view text )
+{
+  const auto num_nodes = read_int( text );
+
+  return csr_type{ num_nodes, count_text_edges( text ), [text]( auto add_edge ) {
+    for_each_text_edge( text, add_edge );
+  }};
+}
+
+///
+/// @brief Create a CSR graph with the same edges as another graph
+///
+/// @param graph - Any graph with get_num_nodes / get_num_edges / neighbors,
+///                i.e., graph_raw
+///
+template< typename csr_type, typename graph_type >
+constexpr csr_type make_csr( const graph_type& graph )
+{
+  return csr_type{ graph.get_num_nodes(), graph.get_num_edges(), [&graph]( auto add_edge ) {
+    for ( size_t idx = 0; idx < graph.get_num_nodes(); ++idx ) {
+      for ( const node_id_t dst_node : graph.neighbors( node_id_t{ idx } ) ) {
+        add_edge( node_id_t{ idx }, dst_node );
+      }
+    }
+  }};
+}
+
+///
+/// @brief Given a uni-directional CSR graph, construct a bi-directional one
+///
+/// The CSR version of double_up_edges in connected.h.  Used by
+/// count_connected.
+///
+template< size_t max_nodes, size_t max_edges >
+constexpr graph_csr< max_nodes, max_edges > double_up_edges(
+  const graph_csr< max_nodes, max_edges >& graph
+)
+{
+  return { graph.get_num_nodes(), graph.get_num_edges() * 2, [&graph]( auto add_edge ) {
+    graph.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+      add_edge( src_node, dst_node );
+      add_edge( dst_node, src_node );
+    });
+  }};
+}
+
+/// @brief CSR graph type for graphs that are loaded at run time
+using runtime_csr_t = graph_csr< dynamic_size, dynamic_size >;
+
+#ifndef NO_HEADER_TESTS
+static_assert( []() {
+  const auto csr = read_graph_csr< graph_csr< 4, 8 > >( "4 2 3 0 1 2 0 0 3" );
+  const auto fanout = csr.neighbors( node_id_t{ 2 } );
+  return csr.get_num_edges() == 4
+    && csr.neighbors( node_id_t{ 1 } ).empty()
+    && fanout.size() == 2
+    && fanout[0] == node_id_t{ 3 }
+    && fanout[1] == node_id_t{ 0 };
+}() );
+
+static_assert( double_up_edges(
+  read_graph_csr< graph_csr< 4, 8 > >( "4 2 3 0 1" ) ).neighbors( node_id_t{ 3 } ).size() == 1 );
+
+/// @brief true if func() is a constant expression, i.e., doesn't throw
+template< auto func >
+constexpr bool is_constant_expression = requires { typename std::bool_constant< ( func(), true ) >; };
+
+// A source or destination past the last node is rejected.  With compile
+// time limits, node 3 still has room in offsets, so it must be checked
+// against the node count rather than the storage.
+static_assert( is_constant_expression< []() { return read_graph_csr< graph_csr< 4, 8 > >( "3 0 2" ); } > );
+static_assert( !is_constant_expression< []() { return read_graph_csr< graph_csr< 4, 8 > >( "3 0 5" ); } > );
+static_assert( !is_constant_expression< []() { return read_graph_csr< graph_csr< 4, 8 > >( "3 3 0 0 1" ); } > );
+static_assert( is_constant_expression< []() {
+  return read_graph_csr< graph_csr< dynamic_size, dynamic_size > >( "3 0 2" ).get_num_edges();
+} > );
+static_assert( !is_constant_expression< []() {
+  return read_graph_csr< graph_csr< dynamic_size, dynamic_size > >( "3 0 5" ).get_num_edges();
+} > );
+static_assert( !is_constant_expression< []() {
+  return read_graph_csr< graph_csr< dynamic_size, dynamic_size > >( "3 3 0 0 1" ).get_num_edges();
+} > );
+#endif
+
+#endif
+
@@ -0,0 +1,188 @@
+#ifndef __GRAPH_GENERATORS_H__
+#define __GRAPH_GENERATORS_H__
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/// @brief Synthetic graphs for benchmarks, as graph text descriptions.
+///
+/// Every generator writes the same format as graph.h - the node count,
+/// then one "src dst" pair per line - so the generated graphs go through
+/// the same parsers as real ones.  Run time only.
+
+/// @brief The shapes of graph that can be generated
+enum class graph_shape_t {
+  random,     ///< Uniformly random edges, average degree 4
+  chain,      ///< 0 -> 1 -> 2 ...  One component, as deep as it gets
+  star,       ///< 0 -> every other node.  One very high degree node
+  grid,       ///< Square grid, edges to the right and down
+  power_law   ///< Random edges with heavy tailed (power law like) degrees
+};
+
+/// @brief Every graph_shape_t, i.e., to benchmark them all
+inline constexpr graph_shape_t all_graph_shapes[] = {
+  graph_shape_t::random, graph_shape_t::chain, graph_shape_t::star,
+  graph_shape_t::grid, graph_shape_t::power_law
+};
+
+/// @brief Gets the name of a shape, as used on the benchmark command line
+constexpr std::string_view graph_shape_name( graph_shape_t shape )
+{
+  switch( shape ) {
+    case graph_shape_t::random:    return "random";
+    case graph_shape_t::chain:     return "chain";
+    case graph_shape_t::star:      return "star";
+    case graph_shape_t::grid:      return "grid";
+    case graph_shape_t::power_law: return "power_law";
+  }
+  return "unknown";
+}
+
+/// @brief Gets the shape with a given name.  Throws std::invalid_argument
+///        if there isn't one.
+inline graph_shape_t parse_graph_shape( std::string_view name )
+{
+  for ( const graph_shape_t shape : all_graph_shapes ) {
+    if ( graph_shape_name( shape ) == name ) {
+      return shape;
+    }
+  }
+  throw std::invalid_argument( "unknown graph shape " + std::string( name ) );
+}
+
+/// @brief A generated graph
+struct generated_graph_t {
+  size_t num_nodes = 0;
+  size_t num_edges = 0;
+  /// The graph description, same format as graph.h
+  std::string text;
+};
+
+///
+/// @brief Builds a graph text description an edge at a time
+///
+/// Uses std::to_chars, so writing the text is a small part of the cost of
+/// generating a graph.
+///
+class graph_text_writer_t {
+  public:
+
+  /// @brief Start a description of a graph with num_nodes nodes
+  ///
+  /// expected_edges only sizes the buffer.
+  ///
+  graph_text_writer_t( size_t num_nodes_arg, size_t expected_edges ) {
+    // Up to 10 digits per id at the sizes we generate, plus separators
+    text.reserve( 24 + expected_edges * 22 );
+    result.num_nodes = num_nodes_arg;
+    append( num_nodes_arg, '\n' );
+  }
+
+  /// @brief Add a src -> dst edge
+  void add_edge( size_t src_node, size_t dst_node ) {
+    append( src_node, ' ' );
+    append( dst_node, '\n' );
+    ++result.num_edges;
+  }
+
+  /// @brief Gets the finished graph
+  generated_graph_t finish() && {
+    result.text = std::move( text );
+    return std::move( result );
+  }
+
+  private:
+
+  void append( size_t value, char separator ) {
+    char digits[ 24 ];
+    text.append( digits, std::to_chars( digits, digits + sizeof( digits ), value ).ptr );
+    text.push_back( separator );
+  }
+
+  std::string text;
+  generated_graph_t result;
+};
+
+///
+/// @brief Generate a graph with about num_edges edges
+///
+/// @param shape      The shape of graph to generate
+/// @param num_edges  Approximate number of edges.  The grid rounds to the
+///                   nearest square.
+/// @param seed       Seed for the random shapes, so runs are repeatable
+///
+inline generated_graph_t generate_graph( graph_shape_t shape, size_t num_edges, uint64_t seed = 1 )
+{
+  std::mt19937_64 rng{ seed };
+
+  switch( shape ) {
+    case graph_shape_t::random: {
+      const size_t num_nodes = std::max< size_t >( num_edges / 2, 1 );
+      std::uniform_int_distribution< size_t > pick{ 0, num_nodes - 1 };
+      graph_text_writer_t writer{ num_nodes, num_edges };
+      for ( size_t edge = 0; edge < num_edges; ++edge ) {
+        const size_t src_node = pick( rng );
+        writer.add_edge( src_node, pick( rng ) );
+      }
+      return std::move( writer ).finish();
+    }
+    case graph_shape_t::chain: {
+      graph_text_writer_t writer{ num_edges + 1, num_edges };
+      for ( size_t node = 0; node < num_edges; ++node ) {
+        writer.add_edge( node, node + 1 );
+      }
+      return std::move( writer ).finish();
+    }
+    case graph_shape_t::star: {
+      graph_text_writer_t writer{ num_edges + 1, num_edges };
+      for ( size_t node = 1; node <= num_edges; ++node ) {
+        writer.add_edge( 0, node );
+      }
+      return std::move( writer ).finish();
+    }
+    case graph_shape_t::grid: {
+      // A side x side grid has 2 * side * ( side - 1 ) edges
+      const size_t side = std::max< size_t >( std::llround( std::sqrt( num_edges / 2.0 ) ), 2 );
+      graph_text_writer_t writer{ side * side, 2 * side * ( side - 1 ) };
+      for ( size_t row = 0; row < side; ++row ) {
+        for ( size_t col = 0; col < side; ++col ) {
+          const size_t node = row * side + col;
+          if ( col + 1 < side ) {
+            writer.add_edge( node, node + 1 );
+          }
+          if ( row + 1 < side ) {
+            writer.add_edge( node, node + side );
+          }
+        }
+      }
+      return std::move( writer ).finish();
+    }
+    case graph_shape_t::power_law: {
+      // Endpoints are num_nodes * u^3 for uniform u, so low numbered nodes
+      // are hubs.  The density of ids goes as x^(-2/3), which gives a heavy
+      // tailed degree distribution without keeping per node state.
+      const size_t num_nodes = std::max< size_t >( num_edges / 4, 1 );
+      std::uniform_real_distribution< double > uniform{ 0.0, 1.0 };
+      const auto pick = [ & ]() {
+        const double u = uniform( rng );
+        return std::min( static_cast< size_t >( num_nodes * u * u * u ), num_nodes - 1 );
+      };
+      graph_text_writer_t writer{ num_nodes, num_edges };
+      for ( size_t edge = 0; edge < num_edges; ++edge ) {
+        const size_t src_node = pick();
+        writer.add_edge( src_node, pick() );
+      }
+      return std::move( writer ).finish();
+    }
+  }
+  throw std::invalid_argument( "unknown graph shape" );
+}
+
+#endif
@@ -0,0 +1,660 @@
+#ifndef __GRAPH_RAW_H__
+#define __GRAPH_RAW_H__
+
+#include <string_view>
+#include <iostream>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
+
+#include "text_parsing.h"
+#include "simd_parsing.h"
+#include "numeric_id.h"
+#include "sized_storage.h"
+
+// Dummy tags for the node_t and edge_t
+struct node_id_tag_t {};
+struct edge_id_tag_t {};
+
+/// @brief Numeric (size_t) id for a graph node.
+using node_id_t = numeric_id_t< node_id_tag_t >;
+
+/// @brief Numeric (size_t) id for a graph edge
+using edge_id_t = numeric_id_t< edge_id_tag_t >;
+
+/// @brief optional graph_id_d
+///
+/// The edge fanout for a graph node is represented by a linked list -
+/// optional_edge_id_t is how the next field in the linked list is stored.
+///
+/// If a method takes or returns edge_id_t, a legal edge is gauranteed.
+/// If a method takes optional_edge_id_t, the edge may not exist
+///
+using optional_edge_id_t = optional_numeric_id_t< edge_id_tag_t >;
+
+/// @brief Node id as stored in a graph with at most max_nodes nodes
+template< size_t max_nodes >
+using compact_node_id_t = numeric_id_t< node_id_tag_t, compact_id_int_t< max_nodes > >;
+
+/// @brief Optional edge id as stored in a graph with at most max_edges edges
+template< size_t max_edges >
+using compact_optional_edge_id_t = optional_numeric_id_t< edge_id_tag_t, compact_id_int_t< max_edges > >;
+
+///
+/// @brief Graph edge class
+///
+/// The edge fanout of any graph node is represented as a linked list.
+/// The edge_t class are the nodes on that list.
+///
+/// The ids are stored in the smallest integers that can hold them, given
+/// the graph's limits.  The methods take and return full width ids.
+///
+template< size_t max_nodes, size_t max_edges >
+class edge_t {
+  public:
+
+  ///
+  /// @brief Edge constructor
+  ///
+  /// Creates a node in the edge fanout linked list.
+  ///
+  /// arg_dst_node - The destination node of the edge.  The source node
+  ///   is the node that owns the start of the list.
+  /// arg_next_edge - The next edge in the edge fanout linked list.  If the
+  ///   optional has no value then we're at the end of the list.
+  ///
+  constexpr edge_t(
+    node_id_t arg_dst_node,
+    optional_edge_id_t arg_next_edge
+  ) : dst_node{arg_dst_node}, next_edge{arg_next_edge} {}
+
+  /// @brief Get the next edge in the edge fanout linked list
+  ///
+  constexpr optional_edge_id_t get_next_edge() const {
+    return next_edge;
+  }
+
+  /// @brief Get the destination node for this edge.
+  ///
+  constexpr node_id_t get_dst_node() const {
+    return dst_node;
+  }
+
+  /// @brief Relink the edge, i.e., to unlink the edge after it
+  ///
+  constexpr void set_next_edge( optional_edge_id_t arg_next_edge ) {
+    next_edge = compact_optional_edge_id_t< max_edges >{ arg_next_edge };
+  }
+
+  /// @brief default constructor for un-initialized edges
+  ///
+  /// Used to create the edge allocator class, edge_storage_t
+  ///
+  constexpr edge_t() = default;
+
+  private:
+  compact_node_id_t< max_nodes > dst_node;
+  compact_optional_edge_id_t< max_edges > next_edge;
+};
+
+// graph.h as a graph_raw: 10000 nodes, and room for its 32999 edges
+// doubled up, so a 16 bit node id and a 32 bit edge id.  Was 32 bytes with
+// size_t ids and std::optional.
+static_assert( sizeof( edge_t< 10000, 65998 > ) == 8 );
+
+/// @brief A pool of graph edges (edge_t class) that can be allocated from
+///
+/// max_edges may be dynamic_size, in which case the pool is sized when it's
+/// constructed.
+///
+/// Freed edges go on a free list, linked through their next_edge fields,
+/// and alloc_edge reuses them before taking new slots.  So a graph that
+/// churns edges stays within the slots it's used at its largest.
+///
+template< size_t max_nodes, size_t max_edges >
+class edge_storage_t {
+  public:
+
+  using edge_type = edge_t< max_nodes, max_edges >;
+
+  constexpr edge_storage_t() = default;
+
+  /// @brief Create a pool that can hold at least capacity edges
+  ///
+  constexpr explicit edge_storage_t( size_t capacity )
+    : edge_memory{ make_sized_array< edge_type, max_edges >( capacity ) } {}
+
+  /// @brief Allocate and initialize an edge
+  ///
+  /// @param dst_node - The destination node ID the edge is connecting to
+  /// @param next_edge - The node edge in the source node's edge fanout linked list
+  ///
+  /// @return The newly allocated edge identifier
+  ///
+  constexpr edge_id_t alloc_edge(
+    node_id_t dst_node,
+    optional_edge_id_t next_edge
+  ) {
+    size_t candidate = next_available;
+    if ( free_head.has_value() ) {
+      candidate = free_head.value().value();
+      free_head = edge_memory.at( candidate ).get_next_edge();
+      --num_free;
+    }
+    else {
+      next_available += 1;
+    }
+    edge_memory.at( candidate ) = edge_type(dst_node, next_edge );
+    return edge_id_t{candidate};
+  }
+
+  /// @brief Return an edge to the pool.  It must already be unlinked from
+  ///        its fanout list.
+  ///
+  constexpr void free_edge( edge_id_t index ) {
+    edge_memory.at( index.value() ) = edge_type( node_id_t{ 0 }, free_head );
+    free_head = index;
+    ++num_free;
+  }
+
+  /// @brief Get a reference to the actual edge data given the edge's identifier
+  ///
+  constexpr const edge_type& get_edge( edge_id_t index ) const
+  {
+    return edge_memory.at( index.value() );
+  }
+
+  /// @brief Get a mutable reference to an edge, i.e., to relink it
+  ///
+  constexpr edge_type& get_edge( edge_id_t index )
+  {
+    return edge_memory.at( index.value() );
+  }
+
+  /// @brief Get the number of edges that are allocated and not freed
+  ///
+  constexpr size_t get_num_edges() const {
+    return next_available - num_free;
+  }
+
+  /// @brief Get the number of edges the pool can hold
+  ///
+  constexpr size_t get_capacity() const {
+    return edge_memory.size();
+  }
+
+  private:
+  sized_array_t< edge_type, max_edges > edge_memory;
+  size_t next_available = 0;
+  optional_edge_id_t free_head;
+  size_t num_free = 0;
+};
+
+///
+/// @brief The destination nodes of a node's edge fanout, as a range
+///
+/// Walks the edge fanout linked list, so graph_raw can be used in range
+/// based for loops the same way as graphs with packed neighbor arrays.
+///
+template< typename edge_pool_type >
+class fanout_range_t {
+  public:
+
+  /// @brief Forward iterator over the fanout list.  Dereferences to the
+  ///        edge's destination node.
+  class iterator {
+    public:
+    using value_type        = node_id_t;
+    using difference_type   = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    constexpr iterator() = default;
+    constexpr iterator( const edge_pool_type* arg_pool, optional_edge_id_t arg_edge )
+      : pool{ arg_pool }, edge{ arg_edge } {}
+
+    constexpr node_id_t operator*() const {
+      return pool->get_edge( edge.value() ).get_dst_node();
+    }
+    constexpr iterator& operator++() {
+      edge = pool->get_edge( edge.value() ).get_next_edge();
+      return *this;
+    }
+    constexpr iterator operator++( int ) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    constexpr bool operator==( const iterator& other ) const {
+      return edge == other.edge;
+    }
+
+    private:
+    const edge_pool_type* pool = nullptr;
+    optional_edge_id_t edge;
+  };
+
+  constexpr fanout_range_t( const edge_pool_type& arg_pool, optional_edge_id_t arg_head )
+    : pool{ &arg_pool }, head{ arg_head } {}
+
+  constexpr iterator begin() const { return iterator{ pool, head }; }
+  constexpr iterator end() const { return iterator{ pool, std::nullopt }; }
+
+  private:
+  const edge_pool_type* pool;
+  optional_edge_id_t head;
+};
+
+/// @brief Graph node.  Owns the head of the node's edge fanout list.
+///
+/// Like edge_t, ids are stored in the smallest integers that fit.
+///
+template< size_t max_nodes, size_t max_edges >
+class node_t {
+  public:
+
+  /// @brief Node constructor
+  ///
+  /// @brief node_id_arg - The unque ID of the node
+  ///
+  constexpr node_t( node_id_t node_id_arg ) : node_id{ node_id_arg } {}
+
+  /// @brief get the node ID
+  constexpr node_id_t get_id() const {
+    return node_id;
+  }
+
+  /// @brief Gets the beginning of the edge fanout list
+  constexpr optional_edge_id_t get_edge_head() const {
+    return edge_head;
+  }
+
+  /// @brief Add a new edge to the node.
+  ///
+  /// dst_node  Destination node.  Creates a node_id -> dst_node edge
+  /// storage   Storage pool to get the new edge from
+  ///
+  constexpr void add_edge( node_id_t dst_node, edge_storage_t< max_nodes, max_edges >& storage)
+  {
+    const edge_id_t new_head = storage.alloc_edge( dst_node, edge_head );
+    edge_head = compact_optional_edge_id_t< max_edges >{ optional_edge_id_t{new_head} };
+  }
+
+  /// @brief Remove an edge from the node.
+  ///
+  /// dst_node  Destination node.  Removes one node_id -> dst_node edge
+  /// storage   Storage pool the edge is returned to
+  ///
+  /// @return false if the node had no edge to dst_node
+  ///
+  constexpr bool remove_edge( node_id_t dst_node, edge_storage_t< max_nodes, max_edges >& storage )
+  {
+    optional_edge_id_t prev_edge;
+    for ( optional_edge_id_t edge_idx = get_edge_head(); edge_idx.has_value(); ) {
+      const auto& edge = storage.get_edge( edge_idx.value() );
+      if ( edge.get_dst_node() == dst_node ) {
+        // Unlink the edge, then free it
+        if ( prev_edge.has_value() ) {
+          storage.get_edge( prev_edge.value() ).set_next_edge( edge.get_next_edge() );
+        }
+        else {
+          edge_head = compact_optional_edge_id_t< max_edges >{ edge.get_next_edge() };
+        }
+        storage.free_edge( edge_idx.value() );
+        return true;
+      }
+      prev_edge = edge_idx;
+      edge_idx = edge.get_next_edge();
+    }
+    return false;
+  }
+
+  /// @brief Point the node at a new edge fanout list, i.e., after compaction
+  ///
+  constexpr void set_edge_head( optional_edge_id_t arg_edge_head ) {
+    edge_head = compact_optional_edge_id_t< max_edges >{ arg_edge_head };
+  }
+
+  /// @brief default constructor for un-initialized nodes
+  ///
+  /// Used to create the edge allocator class, edge_storage_t
+  ///
+  constexpr node_t() = default;
+
+  private:
+
+  compact_node_id_t< max_nodes > node_id;
+  compact_optional_edge_id_t< max_edges > edge_head;
+};
+
+// graph.h as a graph_raw, like edge_t above.  Was 24 bytes with size_t ids
+// and std::optional.
+static_assert( sizeof( node_t< 10000, 65998 > ) == 8 );
+
+///
+/// @brief Component tracker for graphs that don't track components
+///
+/// The default for graph_raw.  Does nothing and takes no space.  A tracker
+/// is constructed with the node count and told about every edge added with
+/// unite.  See tracked_graph_t in union_find.h for the one that tracks.
+///
+struct no_component_tracking_t {
+  constexpr explicit no_component_tracking_t( size_t ) {}
+  constexpr bool unite( node_id_t, node_id_t ) { return false; }
+};
+
+///
+/// @brief Graph with variable storage
+///
+/// max_nodes and max_edges are either compile time limits (std::array
+/// storage, usable in constant expressions) or dynamic_size (std::vector
+/// storage, sized when the graph is constructed).
+///
+/// component_tracker_type is told about every edge as it's added.  With a
+/// disjoint set the graph knows its component count at any moment, without
+/// a count_connected pass.
+///
+template< size_t max_nodes, size_t max_edges, typename component_tracker_type = no_component_tracking_t >
+class graph_raw {
+  public:
+
+  using node_type = node_t< max_nodes, max_edges >;
+  using edge_type = edge_t< max_nodes, max_edges >;
+  using node_array_t = sized_array_t< node_type, max_nodes >;
+  using edge_pool_t = edge_storage_t< max_nodes, max_edges >;
+  using storage_t = std::tuple< node_array_t, edge_pool_t >;
+
+  /// @brief The node limit the graph was instantiated with
+  static constexpr size_t max_num_nodes = max_nodes;
+
+  /// @brief true if the graph keeps a live component count
+  static constexpr bool tracks_components =
+    !std::is_same_v< component_tracker_type, no_component_tracking_t >;
+
+  /// @brief Per node data, i.e., a visited flag for each node
+  template< typename T >
+  using node_data_t = sized_array_t< T, max_nodes >;
+
+  // Standard container like C++ Interfaces
+  using value_type       = typename node_array_t::value_type;
+  using size_type        = typename node_array_t::size_type;
+  using reference        = typename node_array_t::reference;
+  using const_reference  = typename node_array_t::const_reference;
+  using iterator         = typename node_array_t::iterator;
+  using const_iterator   = typename node_array_t::const_iterator;
+
+  // Support iterators
+  constexpr iterator begin()              noexcept { return nodes().begin(); }
+  constexpr const_iterator begin()  const noexcept { return nodes().begin(); }
+  constexpr const_iterator cbegin() const noexcept { return nodes().cbegin(); }
+  constexpr iterator end()                noexcept { return begin() + used_nodes; }
+  constexpr const_iterator end()    const noexcept { return begin() + used_nodes; }
+  constexpr const_iterator cend()   const noexcept { return cbegin() + used_nodes; }
+
+  graph_raw() = delete;
+
+  /// Constructs a graph with "used_nodes_arg" nodes and no edges.
+  ///
+  /// @param used_nodes_arg    - Number of nodes in the graph.
+  /// @param edge_capacity_arg - Number of edges the graph can hold.  Must be
+  ///                            given when max_edges is dynamic_size.
+  ///
+  constexpr graph_raw( size_t used_nodes_arg, size_t edge_capacity_arg = max_edges ) :
+    used_nodes{ used_nodes_arg },
+    storage{
+      make_sized_array< node_type, max_nodes >( used_nodes_arg ),
+      edge_pool_t{ edge_capacity_arg }
+    },
+    components{ used_nodes_arg }
+  {
+    // Initialized each used node with a unique id
+    size_t idx = 0;
+    for( auto& node: *this ) {
+      node = node_type( node_id_t{idx} );
+      ++idx;
+    }
+  }
+
+  /// @brief Add an edge to the graph
+  ///
+  /// src_node - edge source node
+  /// dst_node - edge destination node
+  ///
+  constexpr void add_edge( node_id_t src_node, node_id_t dst_node ) {
+    node_type& node = nodes().at( src_node.value() );
+    node.add_edge( dst_node, edges() );
+    components.unite( src_node, dst_node );
+  }
+
+  /// @brief Remove an edge from the graph
+  ///
+  /// src_node - edge source node
+  /// dst_node - edge destination node
+  ///
+  /// Removes one src_node -> dst_node edge, and its slot is reused by the
+  /// next add_edge.  A disjoint set can't split sets, so a graph that
+  /// tracks components rebuilds its tracker - O(edges).
+  ///
+  /// @return false if there was no such edge
+  ///
+  constexpr bool remove_edge( node_id_t src_node, node_id_t dst_node ) {
+    node_type& node = nodes().at( src_node.value() );
+    if ( !node.remove_edge( dst_node, edges() ) ) {
+      return false;
+    }
+    if constexpr ( tracks_components ) {
+      components = component_tracker_type{ used_nodes };
+      for ( size_t idx = 0; idx < used_nodes; ++idx ) {
+        for ( const node_id_t fanout_node : neighbors( node_id_t{ idx } ) ) {
+          components.unite( node_id_t{ idx }, fanout_node );
+        }
+      }
+    }
+    return true;
+  }
+
+  /// @brief Re-pack the edge pool
+  ///
+  /// Moves every node's fanout into consecutive slots, in node order, and
+  /// drops the free list.  After a lot of removes and adds, traversals
+  /// walk memory in order again.  Fanout order is kept.
+  ///
+  constexpr void compact() {
+    edge_pool_t packed{ edges().get_capacity() };
+
+    for ( node_type& node : *this ) {
+      optional_edge_id_t packed_head;
+      optional_edge_id_t packed_tail;
+      for ( const node_id_t dst_node : neighbors( node.get_id() ) ) {
+        const edge_id_t packed_edge = packed.alloc_edge( dst_node, std::nullopt );
+        if ( packed_tail.has_value() ) {
+          packed.get_edge( packed_tail.value() ).set_next_edge( packed_edge );
+        }
+        else {
+          packed_head = packed_edge;
+        }
+        packed_tail = packed_edge;
+      }
+      node.set_edge_head( packed_head );
+    }
+    edges() = std::move( packed );
+  }
+
+  /// @brief Gets the number of connected subgraphs.  O(1).
+  ///
+  /// Only for graphs that track components, i.e., tracked_graph_t
+  ///
+  constexpr size_t get_num_components() const
+    requires tracks_components
+  {
+    return components.get_num_sets();
+  }
+
+  /// @brief Gets the number of nodes in the graph
+  constexpr size_t get_num_nodes() const {
+    return used_nodes;
+  }
+
+  /// @brief Gets the number of edges in the graph
+  constexpr size_t get_num_edges() const {
+    return edges().get_num_edges();
+  }
+
+  /// @brief Create per node data, value initialized, for every used node
+  template< typename T >
+  constexpr node_data_t< T > make_node_data() const {
+    return make_sized_array< T, max_nodes >( used_nodes );
+  }
+
+  /// @brief Gets the head of the edge linked list.
+  ///
+  /// Note - most of the time this is the only thing we want from a node.  We
+  ///    already have the node id
+  ///
+  constexpr optional_edge_id_t edge_head( node_id_t node_idx )  const {
+    return nodes().at( node_idx.value() ).get_edge_head();
+  }
+
+  /// @brief Get an edge given an edge_id
+  constexpr const edge_type& get_edge( edge_id_t edge_idx ) const {
+    return edges().get_edge( edge_idx );
+  }
+
+  /// @brief Gets the destination nodes of every edge leaving node_idx
+  ///
+  /// for( node_id_t dst_node : graph.neighbors( src_node ) ) { ... }
+  ///
+  constexpr fanout_range_t< edge_pool_t > neighbors( node_id_t node_idx ) const {
+    return { edges(), edge_head( node_idx ) };
+  }
+
+  /// @brief Hint that node_idx's neighbors will be read soon.  A no-op in
+  ///        constant evaluation.
+  ///
+  /// Only node_idx's record, which holds its edge head, is prefetched.  The
+  /// edges themselves can't be, since finding the first one means reading
+  /// that record - the load the prefetch is there to hide.
+  ///
+  constexpr void prefetch( node_id_t node_idx ) const {
+    if ( !std::is_constant_evaluated() ) {
+      __builtin_prefetch( nodes().data() + node_idx.value() );
+    }
+  }
+
+  /// @brief Print the graph by walking nodes and edges.
+  ///
+  void print() const {
+    for( const auto& node : *this ) {
+      std::cout << node.get_id().value() << " -> ";
+      for ( auto edge_idx = node.get_edge_head(); edge_idx.has_value(); ) {
+        const auto& edge = edges().get_edge( edge_idx.value() );
+        std::cout << edge.get_dst_node().value() << " (" << edge_idx.value().value() << ") ";
+        edge_idx = edge.get_next_edge();
+      }
+      std::cout << "\n";
+    }
+  }
+
+  private:
+
+  constexpr node_array_t& nodes() { return std::get<0>(storage); }
+  constexpr edge_pool_t& edges() { return std::get<1>(storage); }
+  constexpr const node_array_t& nodes() const { return std::get<0>(storage); }
+  constexpr const edge_pool_t& edges() const { return std::get<1>(storage); }
+
+  const size_t used_nodes;
+  storage_t storage;
+  [[no_unique_address]] component_tracker_type components;
+};
+
+///
+/// @brief Call func( src, dst ) for each edge in a graph text description
+///
+/// @param text  The edge pairs - the graph text after the node count
+/// @param func  Called with the source and destination node_id_t of each edge
+///
+/// Integers are read in batches with read_ints, which is vectorized at
+/// run time.  As with read_int, a missing destination at the very end of
+/// the text reads as 0.
+///
+template< typename F >
+constexpr void for_each_text_edge( std::string_view text, F func )
+{
+  if ( std::is_constant_evaluated() ) {
+    // Batching only pays off at run time, and costs constexpr operations
+    while( text.size() > 0 ) {
+      auto src_node = read_int( text );
+      auto dst_node = read_int( text );
+      func( node_id_t{src_node}, node_id_t{dst_node} );
+    }
+    return;
+  }
+
+  std::array< size_t, 512 > ints{};
+
+  while( text.size() > 0 ) {
+    const size_t num_ints = read_ints( text, ints );
+    for ( size_t idx = 0; idx < num_ints; idx += 2 ) {
+      const size_t dst_node = idx + 1 < num_ints ? ints[ idx + 1 ] : 0;
+      func( node_id_t{ ints[ idx ] }, node_id_t{ dst_node } );
+    }
+  }
+}
+
+///
+/// @brief The number of edges for_each_text_edge calls func with
+///
+/// @param text  The edge pairs - the graph text after the node count
+///
+/// An odd number of integers ends in a (src, 0) edge, which counts too.
+///
+constexpr size_t count_text_edges( std::string_view text )
+{
+  return ( count_tokens( text ) + 1 ) / 2;
+}
+
+///
+/// @brief Given a graph text description, populate a graph data structure
+///
+/// The first integer in the text is the number of nodes.  It's followed by
+/// pairs of integers, the source and destination node of each edge.
+///
+template< typename graph_type >
+constexpr graph_type read_graph( std::string_view text )
+{
+  auto num_nodes = read_int( text );
+  graph_type graph{ num_nodes, count_text_edges( text ) };
+
+  for_each_text_edge( text, [&]( node_id_t src_node, node_id_t dst_node ) {
+    graph.add_edge( src_node, dst_node );
+  });
+
+  return graph;
+}
+
+/// @brief Graph type for graphs that are loaded at run time
+using runtime_graph_t = graph_raw< dynamic_size, dynamic_size >;
+
+#ifndef NO_HEADER_TESTS
+// Removed edges are unlinked, their slots are reused, and compact keeps
+// the fanout order.
+static_assert( []() {
+  auto graph = read_graph< graph_raw< 4, 4 > >( "4 0 1 0 2 0 3 1 2" );
+  const bool removed = graph.remove_edge( node_id_t{ 0 }, node_id_t{ 2 } )
+    && !graph.remove_edge( node_id_t{ 0 }, node_id_t{ 2 } )
+    && graph.get_num_edges() == 3;
+  // Full pool - only fits because the removed slot is reused
+  graph.add_edge( node_id_t{ 3 }, node_id_t{ 1 } );
+  graph.compact();
+  size_t fanout_sum = 0;
+  for ( const node_id_t dst_node : graph.neighbors( node_id_t{ 0 } ) ) {
+    fanout_sum = fanout_sum * 10 + dst_node.value();
+  }
+  return removed && graph.get_num_edges() == 4 && fanout_sum == 31
+    && graph.edge_head( node_id_t{ 0 } ).value().value() == 0;
+}() );
+#endif
+
+#endif
+
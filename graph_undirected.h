@@ -0,0 +1,285 @@
+#ifndef __GRAPH_UNDIRECTED_H__
+#define __GRAPH_UNDIRECTED_H__
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+#include "graph_raw.h"
+#include "connected.h"
+#include "sized_storage.h"
+#include "union_find.h"
+
+///
+/// @brief Undirected graph edge
+///
+/// One record per input edge, on the fanout lists of both of its ends.
+/// next_edge[ side ] is the next edge in the list of end[ side ].  A self
+/// loop is only on its node's list once, through side 0.
+///
+template< size_t max_nodes, size_t max_edges >
+class undirected_edge_t {
+  public:
+
+  constexpr undirected_edge_t() = default;
+
+  constexpr undirected_edge_t(
+    node_id_t node_a, optional_edge_id_t next_a,
+    node_id_t node_b, optional_edge_id_t next_b
+  ) : end{ compact_node_id_t< max_nodes >{ node_a }, compact_node_id_t< max_nodes >{ node_b } },
+      next_edge{ compact_optional_edge_id_t< max_edges >{ next_a },
+                 compact_optional_edge_id_t< max_edges >{ next_b } } {}
+
+  /// @brief Gets which end of the edge node is, 0 or 1
+  constexpr size_t side_of( node_id_t node ) const {
+    return node_id_t{ end[ 0 ] } == node ? 0 : 1;
+  }
+
+  /// @brief Gets the node at the other end of the edge from node
+  constexpr node_id_t get_other_node( node_id_t node ) const {
+    return end[ 1 - side_of( node ) ];
+  }
+
+  /// @brief Gets the next edge in node's fanout list
+  constexpr optional_edge_id_t get_next_edge( node_id_t node ) const {
+    return next_edge[ side_of( node ) ];
+  }
+
+  /// @brief Gets the ends of the edge, in the order it was added
+  constexpr node_id_t get_src_node() const { return end[ 0 ]; }
+  constexpr node_id_t get_dst_node() const { return end[ 1 ]; }
+
+  private:
+  compact_node_id_t< max_nodes > end[ 2 ];
+  compact_optional_edge_id_t< max_edges > next_edge[ 2 ];
+};
+
+// Two ends and two links.  graph.h has 10000 nodes and 32999 edges, and
+// main.cpp sizes its graph_t to exactly that, so all four are 16 bit ids.
+// A graph_raw of graph.h needs room for 65998 edges once they're doubled
+// up, so its edge_ts have 32 bit links, and there are two of them per input
+// edge - 16 bytes.
+static_assert( sizeof( undirected_edge_t< 10000, 32999 > ) == 8 );
+
+///
+/// @brief Graph that stores each edge once, and lists it for both ends
+///
+/// Connectivity ignores edge direction, so count_connected needs every
+/// edge in both directions.  graph_raw gets that by copying itself with
+/// double_up_edges; this graph is built that way from the start.  Each
+/// add_edge( a, b ) is one record, linked into both a's and b's fanouts,
+/// so neighbors( a ) includes b and neighbors( b ) includes a.  No copy is
+/// made, so a count needs about 2/3 the memory of a graph_raw and its
+/// doubled copy.
+///
+/// Like graph_raw, max_nodes and max_edges may be dynamic_size.
+///
+template< size_t max_nodes, size_t max_edges >
+class graph_undirected {
+  public:
+
+  using edge_type = undirected_edge_t< max_nodes, max_edges >;
+  using head_type = compact_optional_edge_id_t< max_edges >;
+
+  /// @brief The node limit the graph was instantiated with
+  static constexpr size_t max_num_nodes = max_nodes;
+
+  /// @brief neighbors() already goes both ways.  See as_bidirectional.
+  static constexpr bool is_undirected = true;
+
+  /// @brief Per node data, i.e., a visited flag for each node
+  template< typename T >
+  using node_data_t = sized_array_t< T, max_nodes >;
+
+  /// @brief The nodes at the other ends of a node's edges, as a range
+  class fanout_range_t {
+    public:
+
+    class iterator {
+      public:
+      using value_type        = node_id_t;
+      using difference_type   = std::ptrdiff_t;
+      using iterator_category = std::forward_iterator_tag;
+
+      constexpr iterator() = default;
+      constexpr iterator( const graph_undirected* arg_graph, node_id_t arg_node, optional_edge_id_t arg_edge )
+        : graph{ arg_graph }, node{ arg_node }, edge{ arg_edge } {}
+
+      constexpr node_id_t operator*() const {
+        return graph->get_edge( edge.value() ).get_other_node( node );
+      }
+      constexpr iterator& operator++() {
+        edge = graph->get_edge( edge.value() ).get_next_edge( node );
+        return *this;
+      }
+      constexpr iterator operator++( int ) {
+        iterator old = *this;
+        ++*this;
+        return old;
+      }
+      constexpr bool operator==( const iterator& other ) const {
+        return edge == other.edge;
+      }
+
+      private:
+      const graph_undirected* graph = nullptr;
+      node_id_t node{ 0 };
+      optional_edge_id_t edge;
+    };
+
+    constexpr fanout_range_t( const graph_undirected& arg_graph, node_id_t arg_node )
+      : graph{ &arg_graph }, node{ arg_node } {}
+
+    constexpr iterator begin() const { return iterator{ graph, node, graph->edge_head( node ) }; }
+    constexpr iterator end() const { return iterator{ graph, node, std::nullopt }; }
+
+    private:
+    const graph_undirected* graph;
+    node_id_t node;
+  };
+
+  graph_undirected() = delete;
+
+  /// Constructs a graph with "used_nodes_arg" nodes and no edges.
+  ///
+  /// @param used_nodes_arg    - Number of nodes in the graph.
+  /// @param edge_capacity_arg - Number of edges the graph can hold.  Must be
+  ///                            given when max_edges is dynamic_size.
+  ///
+  constexpr graph_undirected( size_t used_nodes_arg, size_t edge_capacity_arg = max_edges ) :
+    used_nodes{ used_nodes_arg },
+    heads{ make_sized_array< head_type, max_nodes >( used_nodes_arg ) },
+    edge_memory{ make_sized_array< edge_type, max_edges >( edge_capacity_arg ) } {}
+
+  /// @brief Add an edge between node_a and node_b
+  ///
+  /// node_a - edge source node
+  /// node_b - edge destination node
+  ///
+  /// The direction is kept, for for_each_edge, but the edge is in both
+  /// nodes' fanouts.
+  ///
+  constexpr void add_edge( node_id_t node_a, node_id_t node_b ) {
+    if ( node_a.value() >= used_nodes || node_b.value() >= used_nodes ) {
+      throw std::out_of_range( "graph_undirected: node out of range" );
+    }
+    const edge_id_t new_edge{ used_edges };
+    head_type& head_a = heads.at( node_a.value() );
+    head_type& head_b = heads.at( node_b.value() );
+    if ( node_a == node_b ) {
+      edge_memory.at( used_edges ) = edge_type{ node_a, head_a, node_b, std::nullopt };
+    }
+    else {
+      edge_memory.at( used_edges ) = edge_type{ node_a, head_a, node_b, head_b };
+      head_b = head_type{ optional_edge_id_t{ new_edge } };
+    }
+    head_a = head_type{ optional_edge_id_t{ new_edge } };
+    ++used_edges;
+  }
+
+  /// @brief Gets the number of nodes in the graph
+  constexpr size_t get_num_nodes() const {
+    return used_nodes;
+  }
+
+  /// @brief Gets the number of edges in the graph, each counted once
+  constexpr size_t get_num_edges() const {
+    return used_edges;
+  }
+
+  /// @brief Create per node data, value initialized, for every used node
+  template< typename T >
+  constexpr node_data_t< T > make_node_data() const {
+    return make_sized_array< T, max_nodes >( used_nodes );
+  }
+
+  /// @brief Gets the head of node_idx's fanout list
+  constexpr optional_edge_id_t edge_head( node_id_t node_idx ) const {
+    return heads.at( node_idx.value() );
+  }
+
+  /// @brief Get an edge given an edge_id
+  constexpr const edge_type& get_edge( edge_id_t edge_idx ) const {
+    return edge_memory.at( edge_idx.value() );
+  }
+
+  /// @brief Gets the nodes at the other ends of node_idx's edges, whichever
+  ///        direction they were added in
+  constexpr fanout_range_t neighbors( node_id_t node_idx ) const {
+    return { *this, node_idx };
+  }
+
+  /// @brief Hint that node_idx's neighbors will be read soon.  A no-op in
+  ///        constant evaluation.
+  ///
+  /// Only node_idx's head slot is prefetched.  Its edge records aren't,
+  /// since finding the first one means reading the head.
+  ///
+  constexpr void prefetch( node_id_t node_idx ) const {
+    if ( !std::is_constant_evaluated() ) {
+      __builtin_prefetch( heads.data() + node_idx.value() );
+    }
+  }
+
+  /// @brief Call func( src, dst ) for every edge in the graph, once, in
+  ///        the direction it was added
+  template< typename F >
+  constexpr void for_each_edge( F func ) const {
+    for ( size_t idx = 0; idx < used_edges; ++idx ) {
+      func( edge_memory[ idx ].get_src_node(), edge_memory[ idx ].get_dst_node() );
+    }
+  }
+
+  private:
+
+  size_t used_nodes;
+  size_t used_edges = 0;
+  sized_array_t< head_type, max_nodes > heads;
+  sized_array_t< edge_type, max_edges > edge_memory;
+};
+
+/// @brief Undirected graph type for graphs that are loaded at run time
+using runtime_undirected_graph_t = graph_undirected< dynamic_size, dynamic_size >;
+
+#ifndef NO_HEADER_TESTS
+// Both ends see the edge, and a self loop is listed once
+static_assert( []() {
+  const auto graph = read_graph< graph_undirected< 4, 3 > >( "4 0 1 2 1 3 3" );
+  size_t fanout_1 = 0;
+  for ( const node_id_t dst_node : graph.neighbors( node_id_t{ 1 } ) ) {
+    fanout_1 = fanout_1 * 10 + dst_node.value();
+  }
+  size_t fanout_3 = 0;
+  for ( const node_id_t dst_node : graph.neighbors( node_id_t{ 3 } ) ) {
+    fanout_3 = fanout_3 * 10 + dst_node.value() + 1;
+  }
+  return graph.get_num_edges() == 3 && fanout_1 == 20 && fanout_3 == 4
+    && graph.neighbors( node_id_t{ 0 } ).begin() != graph.neighbors( node_id_t{ 0 } ).end();
+}() );
+
+// count_connected_dfs uses the graph as it is - a graph_undirected< 8, 7 >
+// has no room for double_up_edges.  The fanouts mix edges a node is the
+// first end of with ones it's the second end of, and there's a self loop
+// and an edge repeated the other way around.  for_each_edge, which
+// count_connected_union_find takes its edges from, gives each edge once,
+// the way it was added.
+static_assert( []() {
+  const auto graph = read_graph< graph_undirected< 8, 7 > >( "8 1 0 1 2 3 2 3 3 2 3 4 5 7 6" );
+  size_t num_edges = 0;
+  size_t first_and_last = 0;
+  graph.for_each_edge( [ & ]( node_id_t src_node, node_id_t dst_node ) {
+    if ( num_edges == 0 || num_edges == 6 ) {
+      first_and_last = first_and_last * 100 + src_node.value() * 10 + dst_node.value();
+    }
+    ++num_edges;
+  });
+  return count_connected_dfs( graph ) == 3 && count_connected_union_find( graph ) == 3
+    && num_edges == 7 && first_and_last == 1076;
+}() );
+// count_connected_bit_parallel, which count_connected picks for a graph
+// this small, sees every edge from both of its ends
+static_assert( count_connected_bit_parallel( read_graph< graph_undirected< 7, 4 > >( "7 1 0 2 1 6 4 5 6" ) ) == 3 );
+#endif
+
+#endif
@@ -1,390 +1,547 @@
 #include <string_view>
+#include <string>
 #include <iostream>
-#include <array>
-#include <tuple>
-#include <type_traits>
+#include <chrono>
+#include <stdexcept>
+#include <optional>
 
-#include "graph.h"
+// The compile time graph, as the char array input[].  Either
+//
+//   -DGRAPH_FILE='"edges.txt"'  pulls in a graph text file with #embed, on
+//                               compilers that have it.  No header needed.
+//   -DGRAPH_HEADER='"other.h"'  includes a header that defines input[],
+//                               i.e., from embed_graph.py, or for
+//                               compile_benchmark.py.
+//
+// With neither, the graph is graph.h.
+#if defined( GRAPH_FILE )
+#if defined( __has_embed )
+constexpr char input[] = {
+#embed GRAPH_FILE suffix(,)
+  0
+};
+#else
+#error "GRAPH_FILE needs #embed.  Use embed_graph.py to make a header, and -DGRAPH_HEADER"
+#endif
+#else
+#ifndef GRAPH_HEADER
+#define GRAPH_HEADER "graph.h"
+#define GRAPH_IS_DEFAULT 1
+#endif
+#include GRAPH_HEADER
+#endif
 #include "text_parsing.h"
-#include "numeric_id.h"
-
-// Dummy tags for the node_t and edge_t
-struct node_id_tag_t {};
-struct edge_id_tag_t {};
-
-/// @brief Numeric (size_t) id for a graph node.
-using node_id_t = numeric_id_t< node_id_tag_t >;
-
-/// @brief Numeric (size_t) id for a graph edge
-using edge_id_t = numeric_id_t< edge_id_tag_t >;
+#include "graph_raw.h"
+#include "graph_undirected.h"
+#include "connected.h"
+#include "union_find.h"
+#include "graph_csr.h"
+#include "parallel_parsing.h"
+#include "mapped_file.h"
+#include "afforest.h"
+#include "concurrent_union_find.h"
+#include "csr_file.h"
+#include "connectivity_query.h"
+#include "edge_dedup.h"
+#include "node_reordering.h"
+#include "bfs_components.h"
+#include "label_propagation.h"
+
+// Wrap the graph description text in a string view.  Sized from the
+// array, less its terminating 0, so there's no strlen to evaluate.
+//
+constexpr std::string_view graph_text{ input, sizeof( input ) - 1 };
+
+// The number of subgraphs in the compile time graph
+#ifndef EXPECTED_SUBGRAPHS
+#define EXPECTED_SUBGRAPHS 12
+#endif
+
+// How far the compile time evaluation goes.  compile_benchmark.py builds
+// each phase on its own to measure what it costs, with -DNO_HEADER_TESTS
+// to leave out the headers' own static_asserts, which would otherwise set
+// the minimum limits for the smaller phases.
+//   0 - nothing, just the headers' static_asserts, if they're on
+//   1 - parse the graph
+//   2 - parse, and also parse the graph into a graph_raw and double up its
+//       edges - the copy graph_undirected saves.  Not part of phase 3.
+//   3 - everything (the default)
+#ifndef COMPILE_TIME_PHASE
+#define COMPILE_TIME_PHASE 3
+#endif
+
+#if COMPILE_TIME_PHASE >= 1
+//
+// Use the string view to compile time compute the number of nodes
+// and edges that will be in the final graph.  Create a graph type,
+// graph_t, with just enough storage for that graph.  It's undirected, so
+// the traversals don't need a doubled up copy of it, and its edge limit is
+// the number of edges - two words each, after the node count.
+//
+constexpr size_t max_graph_nodes = read_int_v( graph_text );
+constexpr size_t max_graph_edges = count_words( graph_text ) / 2;
+using graph_t = graph_undirected< max_graph_nodes, max_graph_edges >;
+#ifdef GRAPH_IS_DEFAULT
+// graph.h's 32999 edges fit 16 bit edge ids
+static_assert( sizeof( graph_t::edge_type ) == 8 );
+#endif
+
+constexpr graph_t graph = read_graph< graph_t >( graph_text );
+#endif
+#if COMPILE_TIME_PHASE == 2
+// The graph as a graph_raw, with room for its doubled up copy
+using raw_graph_t = graph_raw< max_graph_nodes, max_graph_edges * 2 >;
+static_assert( double_up_edges( read_graph< raw_graph_t >( graph_text ) ).get_num_nodes() == max_graph_nodes );
+#endif
+#if COMPILE_TIME_PHASE >= 3
+// Label graph's components.  This is count_connected's traversal, also
+// recording which component each node is in, so the count comes from it
+// rather than from a second traversal.
+constexpr connectivity_query_t graph_connectivity{ graph };
+constexpr int connected_subgraphs = static_cast< int >( graph_connectivity.get_num_components() );
+// The static assert backs up the claim that the number of subgraphs is known
+// at compile time.
+static_assert( connected_subgraphs == EXPECTED_SUBGRAPHS );
+#ifdef CHECK_UNION_FIND
+// The disjoint set engine has to agree.  That's a second full count of the
+// graph, which nearly doubles the compile time, so it's only done on
+// request.  union_find.h checks it against count_connected on small graphs.
+static_assert( count_connected_union_find( graph ) == connected_subgraphs );
+#endif
+// Reachability in graph, answered at compile time
+#ifdef GRAPH_IS_DEFAULT
+static_assert( graph_connectivity.connected( node_id_t{ 0 }, node_id_t{ 9999 } ) );
+static_assert( graph_connectivity.connected( node_id_t{ 4448 }, node_id_t{ 5592 } ) );
+static_assert( !graph_connectivity.connected( node_id_t{ 0 }, node_id_t{ 413 } ) );
+#endif
+#else
+// Not computed in the partial builds
+constexpr int connected_subgraphs = -1;
+#endif
+#ifndef NO_HEADER_TESTS
+// An odd number of integers ends in a ( src, 0 ) edge, here 2 - 0.  Every
+// engine has to agree on the count, and the run time sized graphs have to
+// make room for it.
+static_assert( []() {
+  constexpr std::string_view text = "3 0 1 2";
+  const auto raw = read_graph< runtime_graph_t >( text );
+  const auto csr = read_graph_csr< runtime_csr_t >( text );
+  return count_connected_dfs( raw ) == 1
+    && count_connected_bit_parallel( read_graph< graph_raw< 3, 2 > >( text ) ) == 1
+    && count_connected_dfs( csr ) == 1
+    && count_connected_dfs( read_graph< graph_undirected< dynamic_size, dynamic_size > >( text ) ) == 1
+    && count_connected_union_find( text ) == 1
+    && count_connected_union_find( raw ) == 1
+    && count_connected_bfs( csr ).num_components == 1
+    && count_connected_label_propagation( csr ).num_components == 1
+    && count_connected_dfs( make_graph< runtime_graph_t >( dedup_text_edges( text ) ) ) == 1;
+}() );
+
+// count_connected_dfs also runs on CSR graphs
+static_assert( count_connected_dfs( read_graph_csr< graph_csr< 6, 6 > >( "6 0 1 2 1 4 5" ) ) == 3 );
+// So does count_connected_bit_parallel, which count_connected picks for one
+// this small.  Nodes 0 and 4 are only reached through the reverse of an
+// edge, which the CSR doesn't list.
+static_assert( count_connected_bit_parallel( read_graph_csr< graph_csr< 7, 4 > >( "7 1 0 2 1 6 4 5 6" ) ) == 3 );
+#endif
 
-/// @brief optional graph_id_d
-/// 
-/// The edge fanout for a graph node is represented by a linked list -
-/// optional_edge_id_t is how the next field in the linked list is stored.
 ///
-/// If a method takes or returns edge_id_t, a legal edge is gauranteed.
-/// If a method takes optional_edge_id_t, the edge may not exist
-///  
-using optional_edge_id_t = std::optional<numeric_id_t< edge_id_tag_t >>;
-
+/// @brief Run func and write how long it took to std::cerr
 ///
-/// @brief Graph edge class
-/// 
-/// The edge fanout of any graph node is represented as a linked list.
-/// The edge_t class are the nodes on that list.
-/// 
-class edge_t {
-  public: 
-
-  ///
-  /// @brief Edge constructor 
-  ///
-  /// Creates a node in the edge fanout linked list.
-  /// 
-  /// arg_dst_node - The destination node of the edge.  The source node
-  ///   is the node that owns the start of the list.
-  /// arg_next_edge - The next edge in the edge fanout linked list.  If the
-  ///   optional has no value then we're at the end of the list.
-  /// 
-  constexpr edge_t(
-    node_id_t arg_dst_node, 
-    optional_edge_id_t arg_next_edge
-  ) : dst_node{arg_dst_node}, next_edge{arg_next_edge} {}
-
-  /// @brief Get the next edge in the edge fanout linked list
-  ///
-  constexpr optional_edge_id_t get_next_edge() const {
-    return next_edge;
-  }
-
-  /// @brief Get the destination node for this edge.
-  /// 
-  constexpr node_id_t get_dst_node() const {
-    return dst_node;
-  }
-
-  /// @brief default constructor for un-initialized edges
-  ///
-  /// Used to create the edge allocator class, edge_storage_t
-  ///
-  constexpr edge_t() = default;
-
-  private:
-  node_id_t dst_node;
-  optional_edge_id_t next_edge;
-};
+/// @param phase  Name of the phase being timed
+/// @param func   The phase.  Its return value is passed through.
+///
+template< typename F >
+auto timed( std::string_view phase, F func )
+{
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  auto result = func();
+  const auto elapsed = std::chrono::duration< double, std::milli >( clock::now() - start );
+  std::cerr << phase << ": " << elapsed.count() << " ms\n";
+  return result;
+}
 
-/// @brief A pool of graph edges (edge_t class) that can be allocated from
-/// 
-template< size_t max_edges >
-class edge_storage_t {
-  public:
-
-  constexpr edge_storage_t() = default;
-
-  /// @brief Allocate and initialize an edge
-  ///
-  /// @param dst_node - The destination node ID the edge is connecting to
-  /// @param next_edge - The node edge in the source node's edge fanout linked list
-  ///
-  /// @return The newly allocated edge identifier
-  /// 
-  constexpr edge_id_t alloc_edge( 
-    node_id_t dst_node, 
-    optional_edge_id_t next_edge 
-  ) {
-    const auto candidate = next_available;
-    next_available += 1;
-    edge_memory.at( candidate ) = edge_t(dst_node, next_edge );
-    return edge_id_t{candidate};
-  }
-
-  /// @brief Get a reference to the actual edge data given the edge's identifier
-  ///
-  constexpr const edge_t& get_edge( edge_id_t index ) const
-  {
-    return edge_memory.at( index.value() );
-  }
-
-  private:
-  std::array< edge_t, max_edges > edge_memory;
-  size_t next_available = 0;
+/// @brief Run time mode options, set from the command line
+struct run_options_t {
+  /// Which algorithm to use.  See count_connected_text
+  std::string_view engine = "dfs";
+  /// Number of threads to parse the graph text and run parallel engines with
+  unsigned threads = 1;
+  /// Also time count_connected on the same graph, and report the speedup
+  bool compare = false;
+  /// The graph file.  nullptr means use the compile time graph
+  const char* path = nullptr;
+  /// Write the graph to this CSR file instead of counting.  See csr_file.h
+  const char* convert_path = nullptr;
+  /// Drop duplicate edges and self loops while building the graph
+  bool dedup = false;
+  /// Check every offset and id of a CSR file as it's loaded.  See csr_check_t
+  bool verify_csr = false;
+  /// Relabel the nodes in this order after building the graph
+  std::optional< node_order_t > reorder;
 };
 
-
-class node_t {
-  public:
-
-  /// @brief Node constructor
-  ///
-  /// @brief node_id_arg - The unque ID of the node
-  ///
-  constexpr node_t( node_id_t node_id_arg ) : node_id{ node_id_arg } {}
-
-  /// @brief get the node ID
-  constexpr node_id_t get_id() const { 
-    return node_id; 
-  }
-
-  /// @brief Gets the beginning of the edge fanout list
-  constexpr optional_edge_id_t get_edge_head() const { 
-    return edge_head; 
+/// @brief dedup_text_edges, reporting how many edges were dropped.  With
+///        more than one thread, the text is parsed by parse_edges_parallel.
+deduped_edges_t load_deduped_edges( std::string_view text, const run_options_t& options )
+{
+  deduped_edges_t edges;
+  if ( options.threads > 1 ) {
+    thread_pool_t pool{ options.threads };
+    const parsed_edges_t parsed = timed( "parse_edges_parallel", [&]() { return parse_edges_parallel( text, pool ); } );
+    edges = timed( "dedup_edges", [&]() {
+      return dedup_edges( parsed.get_num_nodes(), parsed.get_num_edges(), [&parsed]( auto add_edge ) {
+        parsed.for_each_edge( add_edge );
+      });
+    } );
   }
-
-  /// @brief Add a new edge to the node.
-  ///
-  /// dst_node  Destination node.  Creates a node_id -> dst_node edge
-  /// storage   Storage pool to get the new edge from
-  ///
-  template< size_t storage_max_edges >
-  constexpr void add_edge( node_id_t dst_node, edge_storage_t<storage_max_edges>& storage)
-  {
-    const edge_id_t new_head = storage.alloc_edge( dst_node, edge_head );
-    edge_head = optional_edge_id_t{new_head};
-  } 
-
-  /// @brief default constructor for un-initialized nodes
-  ///
-  /// Used to create the edge allocator class, edge_storage_t
-  ///
-  constexpr node_t() = default;
-
-  private:
-
-  node_id_t node_id;
-  optional_edge_id_t edge_head;
-};
-
-/// 
-/// @brief Graph with variable storage
-///
-///
-template< size_t max_nodes, size_t max_edges >
-class graph_raw {
-  public:
-
-  using node_array_t = std::array<node_t, max_nodes >;
-  using edge_pool_t = edge_storage_t< max_edges >;
-  using storage_t = std::tuple< node_array_t, edge_pool_t >;
-
-  // Standard container like C++ Interfaces
-  using value_type       = typename node_array_t::value_type;
-  using size_type        = typename node_array_t::size_type;
-  using reference        = typename node_array_t::reference;
-  using const_reference  = typename node_array_t::const_reference;
-  using iterator         = typename node_array_t::iterator;
-  using const_iterator   = typename node_array_t::const_iterator;
-  
-  // Support iterators
-  constexpr iterator begin()              noexcept { return nodes().begin(); }  
-  constexpr const_iterator begin()  const noexcept { return nodes().begin(); }  
-  constexpr const_iterator cbegin() const noexcept { return nodes().cbegin(); }  
-  constexpr iterator end()                noexcept { return begin() + used_nodes; }
-  constexpr const_iterator end()    const noexcept { return begin() + used_nodes; }
-  constexpr const_iterator cend()   const noexcept { return cbegin() + used_nodes; }
-
-  graph_raw() = delete;
-
-  /// Constructs a graph with "used_nodes_arg" nodes and no edges.
-  ///
-  /// @param used_nodes_arg - Number of nodes in the graph.
-  ///
-  constexpr graph_raw( size_t used_nodes_arg ) : storage{}, used_nodes{ used_nodes_arg } {
-    // Initialized each used node with a unique id
-    size_t idx = 0;
-    for( auto& node: *this ) {
-      node = node_t( node_id_t{idx} );
-      ++idx;
-    }
+  else {
+    edges = timed( "dedup_text_edges", [&]() { return dedup_text_edges( text ); } );
   }
+  std::cerr << "dropped edges: " << edges.num_dropped << "\n";
+  return edges;
+}
 
-  /// @brief Add an edge to the graph
-  ///
-  /// src_node - edge source node
-  /// dst_node - edge destination node
-  ///
-  constexpr void add_edge( node_id_t src_node, node_id_t dst_node ) {
-    node_t& node = nodes().at( src_node.value() );
-    node.add_edge( dst_node, edges() );
+/// @brief With --reorder, relabel graph's nodes in that order
+template< typename graph_type >
+graph_type reorder_graph( graph_type graph, const run_options_t& options )
+{
+  if ( !options.reorder.has_value() ) {
+    return graph;
   }
+  return timed( "reorder_nodes", [&]() { return reorder_nodes( graph, options.reorder.value() ).graph; } );
+}
 
-  /// @brief Gets the number of nodes in the graph
-  constexpr size_t get_num_nodes() const {
-    return used_nodes;
+/// @brief read_graph, or read_graph_parallel if there's more than one thread.
+///        With --dedup, the graph is built from load_deduped_edges.
+template< typename graph_type >
+graph_type build_graph( std::string_view text, const run_options_t& options )
+{
+  if ( options.dedup ) {
+    const deduped_edges_t edges = load_deduped_edges( text, options );
+    return timed( "make_graph", [&]() { return make_graph< graph_type >( edges ); } );
   }
-
-  /// @brief Gets the head of the edge linked list.
-  ///
-  /// Note - most of the time this is the only thing we want from a node.  We
-  ///    already have the node id
-  ///
-  constexpr optional_edge_id_t edge_head( node_id_t node_idx )  const {
-    return nodes().at( node_idx.value() ).get_edge_head();
+  if ( options.threads > 1 ) {
+    return timed( "read_graph_parallel", [&]() { return read_graph_parallel< graph_type >( text, options.threads ); } );
   }
+  return timed( "read_graph", [&]() { return read_graph< graph_type >( text ); } );
+}
 
-  /// @brief Get an edge given an edge_id
-  constexpr const edge_t& get_edge( edge_id_t edge_idx ) const {
-    return edges().get_edge( edge_idx );
+/// @brief read_graph_csr, or read_graph_csr_parallel if there's more than one thread.
+///        With --dedup, the graph is built from load_deduped_edges.
+template< typename csr_type >
+csr_type build_graph_csr( std::string_view text, const run_options_t& options )
+{
+  if ( options.dedup ) {
+    const deduped_edges_t edges = load_deduped_edges( text, options );
+    return timed( "make_graph", [&]() { return make_graph< csr_type >( edges ); } );
   }
-
-  /// @brief Print the graph by walking nodes and edges.
-  ///
-  void print() const {
-    for( const auto& node : *this ) {
-      std::cout << node.get_id().value() << " -> ";
-      for ( auto edge_idx = node.get_edge_head(); edge_idx.has_value(); ) {
-        const auto& edge = edges().get_edge( edge_idx.value() );
-        std::cout << edge.get_dst_node().value() << " (" << edge_idx.value().value() << ") ";
-        edge_idx = edge.get_next_edge();
-      }
-      std::cout << "\n";
-    }
+  if ( options.threads > 1 ) {
+    return timed( "read_graph_csr_parallel", [&]() { return read_graph_csr_parallel< csr_type >( text, options.threads ); } );
   }
+  return timed( "read_graph_csr", [&]() { return read_graph_csr< csr_type >( text ); } );
+}
 
-  private:
-
-  constexpr node_array_t& nodes() { return std::get<0>(storage); }  
-  constexpr edge_pool_t& edges() { return std::get<1>(storage); }  
-  constexpr const node_array_t& nodes() const { return std::get<0>(storage); }  
-  constexpr const edge_pool_t& edges() const { return std::get<1>(storage); }  
-
-  const size_t used_nodes;
-  storage_t storage;
-};
-
-// Wrap test graph description text in graph.h in a string view.
-//
-constexpr std::string_view graph_text{ input };
+/// @brief build_graph, then reorder_graph
+template< typename graph_type >
+graph_type load_graph( std::string_view text, const run_options_t& options )
+{
+  return reorder_graph( build_graph< graph_type >( text, options ), options );
+}
 
-//
-// Use the string view to compile time compute the number of nodes
-// and edges that will be in the final graph.  Create a graph type,
-// graph_t, with just enough storage for that graph.
-//
-constexpr size_t max_graph_nodes = read_int_v( graph_text );  
-constexpr size_t max_graph_edges = count_words( graph_text );
-using graph_t = graph_raw< max_graph_nodes, max_graph_edges >;
+/// @brief build_graph_csr, then reorder_graph
+template< typename csr_type >
+csr_type load_graph_csr( std::string_view text, const run_options_t& options )
+{
+  return reorder_graph( build_graph_csr< csr_type >( text, options ), options );
+}
 
 ///
-/// @brief Given a graph text description, populate a graph data structure
+/// @brief Time count_connected on graph and report engine's speedup over it
+///
+/// @param graph         The graph the engine ran on
+/// @param engine_count  The count the engine produced
+/// @param engine_ms     How long the engine took
 ///
-constexpr graph_t read_graph( std::string_view text ) 
+template< typename graph_type >
+void report_speedup( const graph_type& graph, int engine_count, double engine_ms )
 {
-  auto num_nodes = read_int( text ); 
-  graph_t graph{ num_nodes };
-
-  while( text.size() > 0 ) {
-    auto src_node = read_int( text ); 
-    auto dst_node = read_int( text ); 
-    graph.add_edge( node_id_t{src_node}, node_id_t{dst_node} );
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const int serial_count = count_connected( graph );
+  const std::chrono::duration< double, std::milli > serial_ms = clock::now() - start;
+
+  std::cerr << "count_connected: " << serial_ms.count() << " ms\n";
+  std::cerr << "speedup: " << serial_ms.count() / engine_ms << "x\n";
+  if ( serial_count != engine_count ) {
+    throw std::logic_error( "engine and count_connected disagree" );
   }
-
-  return graph;
 }
 
 ///
-/// @brief Given a uni-directional graph, construct a bi-directional graph
+/// @brief count_connected_afforest on options.threads threads.  With
+///        --compare, also reports its speedup over count_connected.
 ///
-/// Used to count connected subgraphs
+template< typename graph_type >
+int count_connected_afforest_compared( const graph_type& graph, const run_options_t& options )
+{
+  thread_pool_t pool{ options.threads };
+  const auto start = std::chrono::steady_clock::now();
+  const int count = timed( "count_connected_afforest", [&]() { return count_connected_afforest( graph, pool ); } );
+  const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+  if ( options.compare ) {
+    report_speedup( graph, count, elapsed.count() );
+  }
+  return count;
+}
+
 ///
-/// Creates a bi-directional graph from a uni-directional graph by adding extra
-/// edges.  i.e.,  if there's an edge from A -> B in the input graph, the output
-/// graph is guaranteed to have both A -> B and B -> A.
+/// @brief connected_components, reporting the largest component
 ///
-constexpr graph_t double_up_edges( const graph_t& graph )
+template< typename graph_type >
+int connected_components_reported( const graph_type& graph )
 {
-  graph_t new_graph{ graph.get_num_nodes() } ;
+  const auto components = timed( "connected_components", [&]() { return connected_components( graph ); } );
+  if ( components.num_components > 0 ) {
+    std::cerr << "largest component: " << components.largest
+      << " (" << components.sizes[ components.largest ] << " nodes)\n";
+  }
+  return static_cast< int >( components.num_components );
+}
 
-  // For each nodes..
-  for( const auto& node : graph ) {
-    const auto node_idx = node.get_id();
+///
+/// @brief count_connected_bfs, reporting how many edges it inspected
+///
+template< typename graph_type >
+int count_connected_bfs_reported( const graph_type& graph )
+{
+  const bfs_components_t result = timed( "count_connected_bfs", [&]() { return count_connected_bfs( graph ); } );
+  std::cerr << "edges inspected: " << result.edges_inspected << " of " << graph.get_num_edges() * 2
+    << " (" << result.top_down_steps << " top-down, " << result.bottom_up_steps << " bottom-up steps)\n";
+  return static_cast< int >( result.num_components );
+}
 
-    // For each edge in the node
-    auto edge_itr = node.get_edge_head();
-    while( edge_itr.has_value() ) {
-      const edge_t& edge = graph.get_edge( edge_itr.value() );
-      const auto dst_node = edge.get_dst_node();
+///
+/// @brief count_connected_label_propagation, reporting the rounds it took
+///
+template< typename graph_type >
+int count_connected_label_propagation_reported( const graph_type& graph )
+{
+  const auto result = timed( "count_connected_label_propagation", [&]() {
+    return count_connected_label_propagation( graph );
+  } );
+  std::cerr << "rounds: " << result.rounds << ", nodes processed: " << result.nodes_processed << "\n";
+  return static_cast< int >( result.num_components );
+}
 
-      // Double up the edge in the new graph
-      new_graph.add_edge( node_idx, dst_node );
-      new_graph.add_edge( dst_node, node_idx );
+///
+/// @brief Count the connected subgraphs in a graph description
+///
+/// @param text     The graph description, same format as graph.h
+/// @param options  options.engine picks the algorithm
+///                 dfs             - read_graph + count_connected
+///                 union_find      - read_graph + count_connected_union_find
+///                 union_find_text - disjoint set fed straight from the text
+///                 components      - read_graph + connected_components, and
+///                                   report the largest component
+///                 tracked         - read_graph into a tracked_graph_t, which
+///                                   counts components as edges are added
+///                 undirected      - read_graph into a graph_undirected +
+///                                   count_connected, with no doubled copy
+///                 csr             - read_graph_csr + count_connected
+///                 bfs             - read_graph_csr + direction optimizing BFS
+///                 label_propagation - read_graph_csr + min label propagation
+///                 afforest        - read_graph_csr + parallel Afforest
+///                 concurrent_union_find - lock free disjoint set fed
+///                                   straight from the text by every thread
+/// @return         The number of connected subgraphs
+///
+int count_connected_text( std::string_view text, const run_options_t& options )
+{
+  const std::string_view engine = options.engine;
 
-      edge_itr = edge.get_next_edge();
-    }
+  if ( engine == "dfs" ) {
+    const auto runtime_graph = load_graph< runtime_graph_t >( text, options );
+    return timed( "count_connected", [&]() { return count_connected( runtime_graph ); } );
+  }
+  if ( engine == "union_find" ) {
+    const auto runtime_graph = load_graph< runtime_graph_t >( text, options );
+    return timed( "count_connected_union_find", [&]() { return count_connected_union_find( runtime_graph ); } );
   }
-  return new_graph;
+  if ( engine == "components" ) {
+    const auto runtime_graph = load_graph< runtime_graph_t >( text, options );
+    return connected_components_reported( runtime_graph );
+  }
+  if ( engine == "tracked" ) {
+    const auto tracked_graph = load_graph< runtime_tracked_graph_t >( text, options );
+    return timed( "get_num_components", [&]() { return static_cast< int >( tracked_graph.get_num_components() ); } );
+  }
+  if ( engine == "undirected" ) {
+    const auto undirected_graph = load_graph< runtime_undirected_graph_t >( text, options );
+    return timed( "count_connected", [&]() { return count_connected( undirected_graph ); } );
+  }
+  if ( engine == "csr" ) {
+    const auto csr_graph = load_graph_csr< runtime_csr_t >( text, options );
+    return timed( "count_connected", [&]() { return count_connected( csr_graph ); } );
+  }
+  if ( engine == "bfs" ) {
+    const auto csr_graph = load_graph_csr< runtime_csr_t >( text, options );
+    return count_connected_bfs_reported( csr_graph );
+  }
+  if ( engine == "label_propagation" ) {
+    const auto csr_graph = load_graph_csr< runtime_csr_t >( text, options );
+    return count_connected_label_propagation_reported( csr_graph );
+  }
+  if ( engine == "afforest" ) {
+    const auto csr_graph = load_graph_csr< runtime_csr_t >( text, options );
+    return count_connected_afforest_compared( csr_graph, options );
+  }
+  // These two never build a graph to drop edges from, or relabel
+  if ( ( engine == "concurrent_union_find" || engine == "union_find_text" )
+    && ( options.dedup || options.reorder.has_value() ) ) {
+    throw std::invalid_argument( "--dedup and --reorder need an engine that builds a graph" );
+  }
+  if ( engine == "concurrent_union_find" ) {
+    thread_pool_t pool{ options.threads };
+    return timed( "count_connected_concurrent", [&]() { return count_connected_concurrent( text, pool ); } );
+  }
+  if ( engine == "union_find_text" ) {
+    return timed( "count_connected_union_find", [&]() { return count_connected_union_find( text ); } );
+  }
+  throw std::invalid_argument( "unknown engine " + std::string( engine ) );
 }
 
 ///
-/// @brief  Mark any nodes graph that are connected to node_idx
-/// 
-/// Used to count connected subgraphs
+/// @brief Count the connected subgraphs in a mapped CSR file
 ///
-/// @param graph     - The graph we're connected the connected subgraphs of
-/// @param node_idx  - The current node we're marking connectivity on
-/// @param visited   - The list of nodes that have already been visited
+/// The engines that work on CSR graphs run straight on the mapped arrays.
+/// The ones that parse text can't be used.
 ///
-/// The functions output is an updated visited array.  Function is recursive
-///
-constexpr void mark_connected( 
-  const graph_t& graph, 
-  node_id_t node_idx, 
-  std::array<bool, max_graph_nodes> &visited
-)
+int count_connected_csr_file( const mapped_csr_t& graph, const run_options_t& options )
 {
-  visited.at( node_idx.value() ) = true;
-
-  auto edge_itr = graph.edge_head( node_idx );
+  const std::string_view engine = options.engine;
 
-  while( edge_itr.has_value() ) {
-    const edge_t& edge = graph.get_edge( edge_itr.value() );
-    const auto dst_node = edge.get_dst_node();
-    if ( !visited.at( dst_node.value() ) ) {
-      mark_connected( graph, dst_node, visited);
-    }
-    edge_itr = edge.get_next_edge();
+  if ( engine == "dfs" || engine == "csr" ) {
+    return timed( "count_connected", [&]() { return count_connected( graph ); } );
+  }
+  if ( engine == "union_find" ) {
+    return timed( "count_connected_union_find", [&]() { return count_connected_union_find( graph ); } );
+  }
+  if ( engine == "components" ) {
+    return connected_components_reported( graph );
+  }
+  if ( engine == "bfs" ) {
+    return count_connected_bfs_reported( graph );
   }
+  if ( engine == "label_propagation" ) {
+    return count_connected_label_propagation_reported( graph );
+  }
+  if ( engine == "afforest" ) {
+    return count_connected_afforest_compared( graph, options );
+  }
+  throw std::invalid_argument( "engine " + std::string( engine ) + " needs a text graph file" );
 }
 
 ///
-/// @brief Count connected subgraphs of a graph
+/// @brief Run time mode.  Count the connected subgraphs in a graph file.
 ///
-/// 1.  Make sure that all edges have a corresponding reverse edge  
-/// 2.  Create an array of graph nodes we've visited
-/// 3.  Search all graph nodes, looking for ones that haven't been visited
-/// 4a. When an unvisited node is found, count it
-/// 4b. Then visit it and anything that connects to it 
+/// The file uses the same format as graph.h, and goes through the same
+/// code as the compile time graph.  Or it's a binary CSR file written by
+/// --convert, which is used in place.  Phase timings are written to
+/// std::cerr so they can be compared against the compile time build.
 ///
-constexpr int count_connected( const graph_t& graph )
+int count_connected_in_file( const run_options_t& options )
 {
-  /// 1. Make sure that all edges have a corresponding reverse edge  
-  graph_t bidir_graph = double_up_edges( graph );
-
-  /// 2. Create an array of graph nodes we've visited
-  std::array< bool, max_graph_nodes> visited = {};
-  for( auto& value : visited ) { value = false; }
-
-  /// 3. Search all graph nodes, looking for ones that haven't been visited
-  int subgraph_count = 0;
-  for ( const auto& node : bidir_graph ) {
-    if ( !visited.at( node.get_id().value() ) ) {
-      /// 4a. When an unvisited node is found, count it
-      ++subgraph_count;
-      /// 4b. Then visit it and anything that connects to it 
-      mark_connected( bidir_graph, node.get_id(), visited );
+  mapped_file_t file = timed( "map", [&]() { return mapped_file_t{ options.path }; } );
+
+  if ( is_csr_file( file.view() ) ) {
+    if ( options.convert_path != nullptr ) {
+      throw std::invalid_argument( "the graph is already a CSR file" );
+    }
+    if ( options.dedup || options.reorder.has_value() ) {
+      throw std::invalid_argument( "--dedup and --reorder only apply to text graphs" );
     }
+    const csr_check_t check = options.verify_csr ? csr_check_t::full : csr_check_t::header;
+    const mapped_csr_t graph = timed( "load_csr_file", [&]() { return mapped_csr_t{ std::move( file ), check }; } );
+    std::cout << count_connected_csr_file( graph, options ) << "\n";
+    return 0;
   }
-  return subgraph_count;
-}
 
-constexpr graph_t graph = read_graph( graph_text );
-constexpr int connected_subgraphs = count_connected( graph );
-// The static assert backs up the claim that the number of subgraphs is known
-// at compile time.
-static_assert( connected_subgraphs == 12 );
+  if ( options.verify_csr ) {
+    throw std::invalid_argument( "--verify-csr only applies to CSR files" );
+  }
+  if ( options.convert_path != nullptr ) {
+    const auto csr_graph = load_graph_csr< runtime_csr_t >( file.view(), options );
+    timed( "write_csr_file", [&]() { write_csr_file( csr_graph, options.convert_path ); return 0; } );
+    return 0;
+  }
+
+  std::cout << count_connected_text( file.view(), options ) << "\n";
+  return 0;
+}
 
+///
+/// Usage: main [--engine=<engine>] [--threads=<n>] [--compare] [--dedup]
+///             [--reorder=bfs|rcm|degree] [--convert=<csr file>]
+///             [--verify-csr] [graph file]
+///
+/// With no graph file, prints the count computed at compile time.  With
+/// --convert, writes the graph file to a binary CSR file instead.  --dedup
+/// drops duplicate edges and self loops from a text graph as it's built,
+/// and --reorder relabels its nodes afterwards.  See node_reordering.h.
+/// --compare, which times afforest against count_connected, only applies
+/// to --engine=afforest.
+/// A CSR file is loaded by checking its header only, unless --verify-csr
+/// asks for every offset and id to be checked too.
+///
 int main( int argc, const char *argv[] ) {
-  std::cout << connected_subgraphs << "\n";
+  run_options_t options;
+
+  try {
+    for ( int arg = 1; arg < argc; ++arg ) {
+      const std::string_view option{ argv[arg] };
+      if ( option.starts_with( "--engine=" ) ) {
+        options.engine = option.substr( std::string_view{ "--engine=" }.size() );
+      }
+      else if ( option.starts_with( "--threads=" ) ) {
+        options.threads = parse_thread_count( option.substr( std::string_view{ "--threads=" }.size() ) );
+      }
+      else if ( option.starts_with( "--convert=" ) ) {
+        options.convert_path = argv[arg] + std::string_view{ "--convert=" }.size();
+      }
+      else if ( option == "--compare" ) {
+        options.compare = true;
+      }
+      else if ( option == "--verify-csr" ) {
+        options.verify_csr = true;
+      }
+      else if ( option == "--dedup" ) {
+        options.dedup = true;
+      }
+      else if ( option.starts_with( "--reorder=" ) ) {
+        options.reorder = parse_node_order( option.substr( std::string_view{ "--reorder=" }.size() ) );
+      }
+      else {
+        options.path = argv[arg];
+      }
+    }
+
+    // Only afforest is timed against count_connected
+    if ( options.compare && ( options.engine != "afforest" || options.path == nullptr || options.convert_path != nullptr ) ) {
+      throw std::invalid_argument( "--compare only applies to the afforest engine, counting a graph file" );
+    }
+
+    if ( options.path == nullptr ) {
+      std::cout << connected_subgraphs << "\n";
+      return 0;
+    }
+
+    return count_connected_in_file( options );
+  }
+  catch( const std::exception& e ) {
+    std::cerr << argv[0] << ": " << e.what() << "\n";
+    return 1;
+  }
 }
 
@@ -0,0 +1,109 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+///
+/// @brief A file mapped read only into memory
+///
+/// The text parsers all work on std::string_view, so they can parse the
+/// mapping directly.  Nothing is copied - memory use is the page cache, not
+/// a second copy of the file.  By default the mapping is advised as
+/// sequential since the parsers read front to back.
+///
+/// Throws std::system_error if the file can't be opened or mapped.
+///
+class mapped_file_t {
+  public:
+
+  mapped_file_t() = delete;
+
+  /// @brief Map the file at path
+  ///
+  /// @param advice  madvise advice for the mapping, i.e., MADV_NORMAL for
+  ///                files that aren't read front to back
+  ///
+  explicit mapped_file_t( const char* path, int advice = MADV_SEQUENTIAL ) {
+    const int fd = ::open( path, O_RDONLY );
+    if ( fd < 0 ) {
+      throw_error( "open", path );
+    }
+
+    struct stat file_stat;
+    if ( ::fstat( fd, &file_stat ) != 0 ) {
+      const int error = errno;
+      ::close( fd );
+      errno = error;
+      throw_error( "fstat", path );
+    }
+    size = static_cast< size_t >( file_stat.st_size );
+
+    // mmap can't map zero bytes; an empty file is an empty view
+    if ( size > 0 ) {
+      void* mapping = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      if ( mapping == MAP_FAILED ) {
+        const int error = errno;
+        ::close( fd );
+        errno = error;
+        throw_error( "mmap", path );
+      }
+      data = static_cast< const char* >( mapping );
+      // Only a hint, so failure isn't an error
+      ::madvise( mapping, size, advice );
+    }
+    // The mapping keeps the file alive
+    ::close( fd );
+  }
+
+  mapped_file_t( const mapped_file_t& ) = delete;
+  mapped_file_t& operator=( const mapped_file_t& ) = delete;
+
+  mapped_file_t( mapped_file_t&& other ) noexcept
+    : data{ std::exchange( other.data, nullptr ) }, size{ std::exchange( other.size, 0 ) } {}
+
+  mapped_file_t& operator=( mapped_file_t&& other ) noexcept {
+    std::swap( data, other.data );
+    std::swap( size, other.size );
+    return *this;
+  }
+
+  ~mapped_file_t() {
+    if ( data != nullptr ) {
+      ::munmap( const_cast< char* >( data ), size );
+    }
+  }
+
+  /// @brief Change the mapping's madvise advice, i.e., once a file turns
+  ///        out to be read in some other order than front to back
+  void advise( int advice ) const {
+    if ( size > 0 ) {
+      ::madvise( const_cast< char* >( data ), size, advice );
+    }
+  }
+
+  /// @brief Gets the file contents
+  std::string_view view() const {
+    return { data, size };
+  }
+
+  private:
+
+  [[noreturn]] static void throw_error( const char* what, const char* path ) {
+    throw std::system_error( errno, std::generic_category(), std::string( what ) + " " + path );
+  }
+
+  const char* data = nullptr;
+  size_t size = 0;
+};
+
+#endif
+
@@ -1,25 +1,134 @@
 #ifndef __NODE_ID_H__
 #define __NODE_ID_H__
 
-#include<optional>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
 
-/// @brief 
-template < typename tag >
-class numeric_id_t 
+/// @brief Type safe numeric id
+///
+/// tag keeps ids for different things (nodes, edges) from being mixed up.
+/// int_t is the integer the id is stored in.  Narrow ids convert to wider
+/// ones with the same tag implicitly.  Going the other way is explicit, and
+/// throws std::out_of_range if the value doesn't fit.
+///
+/// The largest int_t value is reserved for optional_numeric_id_t, so it's
+/// never a legal id for narrow id types.
+///
+template < typename tag, typename int_t = size_t >
+class numeric_id_t
 {
   public:
 
-  constexpr explicit numeric_id_t( size_t arg_id ) noexcept : id{arg_id} {}
+  using int_type = int_t;
+
+  constexpr explicit numeric_id_t( size_t arg_id ) : id{ narrow( arg_id ) } {}
   constexpr numeric_id_t() noexcept = default;
 
+  template< typename other_int_t >
+  constexpr explicit( sizeof( other_int_t ) > sizeof( int_t ) )
+  numeric_id_t( numeric_id_t< tag, other_int_t > other ) : id{ narrow( other.value() ) } {}
+
   constexpr size_t value() const
   {
     return id;
   }
 
+  constexpr bool operator==( const numeric_id_t& ) const = default;
+
   private:
-  size_t id = 0;
+
+  static constexpr int_t narrow( size_t arg_id )
+  {
+    if constexpr ( sizeof( int_t ) < sizeof( size_t ) ) {
+      if ( arg_id >= std::numeric_limits< int_t >::max() ) {
+        throw std::out_of_range( "numeric_id_t: id doesn't fit" );
+      }
+    }
+    return static_cast< int_t >( arg_id );
+  }
+
+  int_t id = 0;
 };
 
+/// @brief An optional numeric_id_t that's the same size as numeric_id_t
+///
+/// Empty is encoded as the largest int_t value, so unlike
+/// std::optional< numeric_id_t > there's no separate flag (and padding) in
+/// the object.  The interface is the subset of std::optional the graph
+/// code uses.
+///
+template < typename tag, typename int_t = size_t >
+class optional_numeric_id_t
+{
+  public:
+
+  using id_t = numeric_id_t< tag, int_t >;
+
+  constexpr optional_numeric_id_t() noexcept = default;
+  constexpr optional_numeric_id_t( std::nullopt_t ) noexcept {}
+  constexpr optional_numeric_id_t( id_t arg_id ) noexcept : id{ static_cast< int_t >( arg_id.value() ) } {}
+
+  template< typename other_int_t >
+  constexpr explicit( sizeof( other_int_t ) > sizeof( int_t ) )
+  optional_numeric_id_t( optional_numeric_id_t< tag, other_int_t > other ) {
+    if ( other.has_value() ) {
+      id = static_cast< int_t >( id_t{ other.value() }.value() );
+    }
+  }
+
+  constexpr bool has_value() const noexcept
+  {
+    return id != empty;
+  }
+
+  constexpr explicit operator bool() const noexcept
+  {
+    return has_value();
+  }
+
+  constexpr id_t value() const
+  {
+    if ( !has_value() ) {
+      throw std::bad_optional_access();
+    }
+    return id_t{ id };
+  }
+
+  constexpr bool operator==( const optional_numeric_id_t& ) const = default;
+
+  private:
+
+  static constexpr int_t empty = std::numeric_limits< int_t >::max();
+
+  int_t id = empty;
+};
+
+///
+/// @brief Smallest unsigned integer that can store ids for max_count things
+///
+/// Leaves the largest value free for optional_numeric_id_t.  Storage sized at
+/// run time (max_count is dynamic_size) gets 32 bit ids - plenty for any
+/// graph that fits in memory, and ids that don't fit throw.
+///
+template< size_t max_count >
+using compact_id_int_t =
+  std::conditional_t< max_count == std::numeric_limits< size_t >::max(), uint32_t,
+  std::conditional_t< max_count <= std::numeric_limits< uint8_t >::max(),  uint8_t,
+  std::conditional_t< max_count <= std::numeric_limits< uint16_t >::max(), uint16_t,
+  std::conditional_t< max_count <= std::numeric_limits< uint32_t >::max(), uint32_t,
+  uint64_t > > > >;
+
+static_assert( std::is_same_v< compact_id_int_t< 255 >, uint8_t > );
+static_assert( std::is_same_v< compact_id_int_t< 256 >, uint16_t > );
+static_assert( std::is_same_v< compact_id_int_t< 33001 >, uint16_t > );
+static_assert( sizeof( optional_numeric_id_t< struct test_tag_t, uint16_t > ) == 2 );
+static_assert( !optional_numeric_id_t< struct test_tag_t, uint16_t >{}.has_value() );
+static_assert( optional_numeric_id_t< struct test_tag_t, uint8_t >{
+  numeric_id_t< struct test_tag_t, uint8_t >{ 7 } }.value().value() == 7 );
+
 #endif
 
@@ -0,0 +1,127 @@
+#ifndef __PARALLEL_CSR_H__
+#define __PARALLEL_CSR_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "graph_csr.h"
+#include "thread_pool.h"
+
+///
+/// @brief Build a run time CSR graph on a thread pool
+///
+/// @param num_nodes    - Number of nodes in the graph
+/// @param num_sources  - Number of independent edge sources, i.e., parsed
+///                       text chunks or ranges of nodes
+/// @param for_each_source_edge - Called as for_each_source_edge( source,
+///                       add_edge ) for every source, from any thread.  It
+///                       calls add_edge( src, dst ) once for each of the
+///                       source's edges, and must produce the same edges
+///                       both times it's called.
+/// @param pool         - Threads to build on
+///
+/// The nodes are split into ranges, small enough that a range's offsets
+/// stay in cache.  Every source counts its edges per range, then copies
+/// them into a staging array grouped by range, sources in order.  Each
+/// range then builds its own slice of the CSR arrays - the graph_csr
+/// constructor's counting pass, prefix sum and fill pass - starting at the
+/// number of edges in the ranges before it.  No two threads write the same
+/// counter, so there are no atomics, and every node's neighbors come out in
+/// source order, as if the sources had been walked one after another.
+///
+/// Throws std::out_of_range for an edge with a node >= num_nodes.
+///
+template< typename csr_type, typename F >
+csr_type make_csr_parallel( size_t num_nodes, size_t num_sources, F for_each_source_edge, thread_pool_t& pool )
+{
+  using offset_t = typename csr_type::offset_t;
+  using stored_node_id_t = typename csr_type::stored_node_id_t;
+  using node_int_t = typename stored_node_id_t::int_type;
+
+  // 64K nodes' offsets per range, but at least a few ranges per thread.
+  // No more than 4096 ranges, even on a pool big enough to want more.
+  constexpr size_t max_ranges = 4096;
+  const size_t min_ranges = std::min< size_t >( pool.size() * 4, max_ranges );
+  const size_t num_ranges = std::clamp< size_t >( num_nodes / 65536, min_ranges, max_ranges );
+  const size_t range_size = num_nodes / num_ranges + 1;
+  const auto range_of = [ range_size ]( node_id_t node ) {
+    return node.value() / range_size;
+  };
+
+  // edge_start[ range * num_sources + source ] is where source's edges in
+  // range go in the staging array.  First it counts them.
+  std::vector< size_t > edge_start( num_ranges * num_sources + 1 );
+  pool.parallel_for( 0, num_sources, [ & ]( size_t first, size_t last ) {
+    for ( size_t source = first; source < last; ++source ) {
+      for_each_source_edge( source, [ & ]( node_id_t src_node, node_id_t dst_node ) {
+        if ( src_node.value() >= num_nodes || dst_node.value() >= num_nodes ) {
+          throw std::out_of_range( "make_csr_parallel: node out of range" );
+        }
+        ++edge_start[ range_of( src_node ) * num_sources + source + 1 ];
+      });
+    }
+  }, 1 );
+  for ( size_t idx = 1; idx < edge_start.size(); ++idx ) {
+    edge_start[ idx ] += edge_start[ idx - 1 ];
+  }
+  const size_t num_edges = edge_start.back();
+  if ( num_edges > std::numeric_limits< offset_t >::max() ) {
+    throw std::out_of_range( "make_csr_parallel: too many edges for offset_t" );
+  }
+
+  // Stage the edges, grouped by range
+  std::vector< std::pair< node_int_t, node_int_t > > staged( num_edges );
+  pool.parallel_for( 0, num_sources, [ & ]( size_t first, size_t last ) {
+    for ( size_t source = first; source < last; ++source ) {
+      std::vector< size_t > cursor( num_ranges );
+      for ( size_t range = 0; range < num_ranges; ++range ) {
+        cursor[ range ] = edge_start[ range * num_sources + source ];
+      }
+      for_each_source_edge( source, [ & ]( node_id_t src_node, node_id_t dst_node ) {
+        staged[ cursor[ range_of( src_node ) ]++ ] =
+          { static_cast< node_int_t >( src_node.value() ), static_cast< node_int_t >( dst_node.value() ) };
+      });
+    }
+  }, 1 );
+
+  // Build each range's slice of the arrays
+  std::vector< offset_t > offsets( num_nodes + 1 );
+  std::vector< stored_node_id_t > neighbor_ids( num_edges );
+  pool.parallel_for( 0, num_ranges, [ & ]( size_t first, size_t last ) {
+    for ( size_t range = first; range < last; ++range ) {
+      const size_t first_node = std::min( range * range_size, num_nodes );
+      const size_t last_node = std::min( first_node + range_size, num_nodes );
+      const size_t first_edge = edge_start[ range * num_sources ];
+      const size_t last_edge = edge_start[ ( range + 1 ) * num_sources ];
+
+      // Counting pass, into a per range cursor for each node
+      std::vector< offset_t > cursor( last_node - first_node );
+      for ( size_t edge = first_edge; edge < last_edge; ++edge ) {
+        ++cursor[ staged[ edge ].first - first_node ];
+      }
+      // Prefix sum, from the range's first edge.  offsets[ src ] becomes
+      // the start of src's neighbors, and so does its cursor.
+      size_t sum = first_edge;
+      for ( size_t node = first_node; node < last_node; ++node ) {
+        const size_t degree = cursor[ node - first_node ];
+        offsets[ node ] = static_cast< offset_t >( sum );
+        cursor[ node - first_node ] = static_cast< offset_t >( sum );
+        sum += degree;
+      }
+      // Fill pass
+      for ( size_t edge = first_edge; edge < last_edge; ++edge ) {
+        const auto [ src_node, dst_node ] = staged[ edge ];
+        neighbor_ids[ cursor[ src_node - first_node ]++ ] = stored_node_id_t{ node_id_t{ dst_node } };
+      }
+    }
+  }, 1 );
+  offsets[ num_nodes ] = static_cast< offset_t >( num_edges );
+
+  return csr_type{ std::move( offsets ), std::move( neighbor_ids ) };
+}
+
+#endif
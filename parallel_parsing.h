@@ -0,0 +1,212 @@
+#ifndef __PARALLEL_PARSING_H__
+#define __PARALLEL_PARSING_H__
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "graph_raw.h"
+#include "graph_csr.h"
+#include "parallel_csr.h"
+#include "thread_pool.h"
+#include "simd_parsing.h"
+#include "text_parsing.h"
+
+/// @brief Multithreaded loading of large graph text descriptions.
+///
+/// The edge pairs are split into chunks at newline boundaries, each thread
+/// parses its chunk with read_ints into its own buffer of 32 bit ids.  A
+/// CSR graph is then built from the buffers in parallel by
+/// make_csr_parallel; other graphs take the edges one at a time.  Either
+/// way, the graph comes out the same as from the serial read_graph.  Run
+/// time only.
+
+///
+/// @brief Split text into at most num_chunks pieces, ending each at a newline
+///
+/// @param text        The text to split
+/// @param num_chunks  How many pieces to aim for.  Pieces are about the same
+///                    size; there are fewer if text has few newlines.
+/// @return            Pieces that concatenate back to text
+///
+inline std::vector< std::string_view > split_at_newlines( std::string_view text, size_t num_chunks )
+{
+  std::vector< std::string_view > chunks;
+  const size_t target_size = text.size() / std::max< size_t >( num_chunks, 1 ) + 1;
+
+  while( text.size() > 0 ) {
+    size_t split = std::min( target_size, text.size() );
+    // Move the split forward to just past the next newline
+    split = text.find( '\n', split - 1 );
+    split = split == std::string_view::npos ? text.size() : split + 1;
+    chunks.push_back( text.substr( 0, split ) );
+    text.remove_prefix( split );
+  }
+  return chunks;
+}
+
+///
+/// @brief Edge pairs parsed by parse_edges_parallel
+///
+/// Each chunk's integers are kept in the buffer the thread that parsed them
+/// wrote.  The integers are paired up across buffers, so an edge that was
+/// split over a newline (which the text format allows) still comes out
+/// right.
+///
+class parsed_edges_t {
+  public:
+
+  /// @brief Node ids as they're parsed - the same 32 bits run time graphs
+  ///        store them in
+  using parsed_id_t = compact_id_int_t< dynamic_size >;
+
+  parsed_edges_t( size_t num_nodes_arg, std::vector< std::vector< parsed_id_t > > chunk_ints_arg )
+    : num_nodes{ num_nodes_arg }, chunk_ints{ std::move( chunk_ints_arg ) }, chunk_first( chunk_ints.size() + 1 )
+  {
+    for ( size_t chunk = 0; chunk < chunk_ints.size(); ++chunk ) {
+      chunk_first[ chunk + 1 ] = chunk_first[ chunk ] + chunk_ints[ chunk ].size();
+    }
+  }
+
+  /// @brief Gets the node count from the start of the text
+  size_t get_num_nodes() const {
+    return num_nodes;
+  }
+
+  /// @brief Gets the number of edges that were parsed
+  size_t get_num_edges() const {
+    return ( chunk_first.back() + 1 ) / 2;
+  }
+
+  /// @brief Gets the number of buffers the edges were parsed into
+  size_t get_num_chunks() const {
+    return chunk_ints.size();
+  }
+
+  /// @brief Call func( src, dst ) for each edge whose source is in chunk
+  ///
+  /// An edge that starts at the end of a chunk takes its destination from
+  /// the next chunk that has any integers.  As with read_int, a missing
+  /// destination at the very end reads as 0.  Chunks can be walked by
+  /// different threads.
+  ///
+  template< typename F >
+  void for_each_chunk_edge( size_t chunk, F func ) const {
+    const auto& ints = chunk_ints[ chunk ];
+    // With an odd number of integers before it, the chunk starts with the
+    // destination of the previous chunk's last edge
+    size_t idx = chunk_first[ chunk ] % 2;
+    for ( ; idx + 1 < ints.size(); idx += 2 ) {
+      func( node_id_t{ ints[ idx ] }, node_id_t{ ints[ idx + 1 ] } );
+    }
+    if ( idx < ints.size() ) {
+      size_t next = chunk + 1;
+      while ( next < chunk_ints.size() && chunk_ints[ next ].empty() ) {
+        ++next;
+      }
+      func( node_id_t{ ints[ idx ] }, node_id_t{ next < chunk_ints.size() ? chunk_ints[ next ][ 0 ] : 0 } );
+    }
+  }
+
+  /// @brief Call func( src, dst ) for each edge, in text order
+  template< typename F >
+  void for_each_edge( F func ) const {
+    for ( size_t chunk = 0; chunk < chunk_ints.size(); ++chunk ) {
+      for_each_chunk_edge( chunk, func );
+    }
+  }
+
+  private:
+
+  size_t num_nodes;
+  std::vector< std::vector< parsed_id_t > > chunk_ints;
+  /// chunk_first[ c ] is the number of integers in the chunks before c
+  std::vector< size_t > chunk_first;
+};
+
+///
+/// @brief Parse a graph text description using several threads
+///
+/// @param text  The graph description, same format as read_graph
+/// @param pool  Threads to parse with.  The text is split into a chunk per
+///              thread.
+/// @return      The node count and the parsed edges
+///
+/// Throws std::out_of_range for an integer that doesn't fit a parsed_id_t.
+///
+inline parsed_edges_t parse_edges_parallel( std::string_view text, thread_pool_t& pool )
+{
+  using parsed_id_t = parsed_edges_t::parsed_id_t;
+
+  const auto num_nodes = read_int( text );
+  const auto chunks = split_at_newlines( text, pool.size() );
+  std::vector< std::vector< parsed_id_t > > chunk_ints( chunks.size() );
+
+  pool.parallel_for( 0, chunks.size(), [ & ]( size_t first, size_t last ) {
+    for ( size_t chunk = first; chunk < last; ++chunk ) {
+      std::string_view remaining = chunks[ chunk ];
+      auto& ints = chunk_ints[ chunk ];
+      // Integers in the text average at least 4 bytes with whitespace.
+      ints.reserve( remaining.size() / 4 + 1 );
+
+      // read_ints writes size_ts, so parse a block at a time and narrow
+      std::array< size_t, 1024 > block;
+      read_whitespace( remaining );
+      while( remaining.size() > 0 ) {
+        const size_t count = read_ints( remaining, block );
+        for ( size_t idx = 0; idx < count; ++idx ) {
+          if ( block[ idx ] > std::numeric_limits< parsed_id_t >::max() ) {
+            throw std::out_of_range( "parse_edges_parallel: node id doesn't fit in 32 bits" );
+          }
+          ints.push_back( static_cast< parsed_id_t >( block[ idx ] ) );
+        }
+      }
+    }
+  }, 1 );
+
+  return { num_nodes, std::move( chunk_ints ) };
+}
+
+///
+/// @brief read_graph, parsing with num_threads threads
+///
+/// Parsing runs in parallel; inserting the edges into the graph is serial.
+/// For CSR graphs, read_graph_csr_parallel builds in parallel too.
+///
+template< typename graph_type >
+graph_type read_graph_parallel( std::string_view text, unsigned num_threads )
+{
+  thread_pool_t pool{ num_threads };
+  const parsed_edges_t edges = parse_edges_parallel( text, pool );
+  graph_type graph{ edges.get_num_nodes(), edges.get_num_edges() };
+
+  edges.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+    graph.add_edge( src_node, dst_node );
+  });
+
+  return graph;
+}
+
+///
+/// @brief read_graph_csr, parsing and building with num_threads threads
+///
+/// The CSR arrays are built straight from the parsed chunks, by
+/// make_csr_parallel.  The graph is the same as from read_graph_csr.
+///
+template< typename csr_type >
+csr_type read_graph_csr_parallel( std::string_view text, unsigned num_threads )
+{
+  thread_pool_t pool{ num_threads };
+  const parsed_edges_t edges = parse_edges_parallel( text, pool );
+
+  return make_csr_parallel< csr_type >( edges.get_num_nodes(), edges.get_num_chunks(),
+    [ &edges ]( size_t chunk, auto add_edge ) {
+      edges.for_each_chunk_edge( chunk, add_edge );
+    }, pool );
+}
+
+#endif
+
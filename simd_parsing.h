@@ -0,0 +1,282 @@
+#ifndef __SIMD_PARSING_H__
+#define __SIMD_PARSING_H__
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_PARSING_X86 1
+#endif
+
+#include "text_parsing.h"
+
+/// @brief Bulk integer parsing for large graph files.
+///
+/// read_ints is a drop in replacement for calling read_int in a loop.  In
+/// constant evaluation it is exactly that loop.  At run time it classifies
+/// 64 bytes of whitespace per step with SIMD compares (AVX2 when the CPU
+/// has it, SSE2 otherwise, plain C++ on other targets), walks the token
+/// boundaries with count trailing zeros, and converts tokens of up to 8
+/// digits with a SWAR multiply instead of digit by digit.
+
+namespace simd_parsing_detail {
+
+/// @brief Bit i is set if p[i] is whitespace, for i in [0, 64)
+inline uint64_t whitespace_mask_scalar( const char* p )
+{
+  uint64_t mask = 0;
+  for ( unsigned idx = 0; idx < 64; ++idx ) {
+    const bool c_is_whitespace = ( p[idx] == ' ' || p[idx] == '\n' );
+    mask |= uint64_t{ c_is_whitespace } << idx;
+  }
+  return mask;
+}
+
+#ifdef SIMD_PARSING_X86
+
+/// @brief whitespace_mask_scalar using SSE2 (16 bytes per compare)
+inline uint64_t whitespace_mask_sse2( const char* p )
+{
+  const __m128i space = _mm_set1_epi8( ' ' );
+  const __m128i newline = _mm_set1_epi8( '\n' );
+  uint64_t mask = 0;
+  for ( unsigned idx = 0; idx < 64; idx += 16 ) {
+    const __m128i bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + idx ) );
+    const __m128i is_ws = _mm_or_si128( _mm_cmpeq_epi8( bytes, space ), _mm_cmpeq_epi8( bytes, newline ) );
+    mask |= uint64_t{ static_cast< uint16_t >( _mm_movemask_epi8( is_ws ) ) } << idx;
+  }
+  return mask;
+}
+
+/// @brief whitespace_mask_scalar using AVX2 (32 bytes per compare)
+[[gnu::target("avx2")]]
+inline uint64_t whitespace_mask_avx2( const char* p )
+{
+  const __m256i space = _mm256_set1_epi8( ' ' );
+  const __m256i newline = _mm256_set1_epi8( '\n' );
+  const __m256i lo = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p ) );
+  const __m256i hi = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p + 32 ) );
+  const __m256i lo_ws = _mm256_or_si256( _mm256_cmpeq_epi8( lo, space ), _mm256_cmpeq_epi8( lo, newline ) );
+  const __m256i hi_ws = _mm256_or_si256( _mm256_cmpeq_epi8( hi, space ), _mm256_cmpeq_epi8( hi, newline ) );
+  return uint64_t{ static_cast< uint32_t >( _mm256_movemask_epi8( lo_ws ) ) }
+    | ( uint64_t{ static_cast< uint32_t >( _mm256_movemask_epi8( hi_ws ) ) } << 32 );
+}
+
+#endif
+
+///
+/// @brief Convert a token of 1 to 8 digits to an integer
+///
+/// Loads 8 bytes from the start of the token, so there must be at least 8
+/// readable bytes there.  The digits are shifted to the top of the word,
+/// which leaves zeros as leading digits, then combined pairwise - 2, 4 and
+/// 8 digits at a time - with three multiplies.
+///
+inline size_t eight_digits_to_int( const char* token, size_t length )
+{
+  uint64_t val;
+  std::memcpy( &val, token, sizeof( val ) );
+  val -= 0x3030303030303030;
+  val <<= ( 8 - length ) * 8;
+  val = ( val * 10 ) + ( val >> 8 );
+  val = ( ( ( val & 0x000000FF000000FF ) * ( 100 + ( 1000000ULL << 32 ) ) )
+        + ( ( ( val >> 16 ) & 0x000000FF000000FF ) * ( 1 + ( 10000ULL << 32 ) ) ) ) >> 32;
+  return val;
+}
+
+///
+/// @brief The block loop behind read_ints
+///
+/// Works on 64 byte blocks while there's a full block plus 8 bytes of
+/// slack (for eight_digits_to_int) left.  Stops at a token boundary, so
+/// the caller can finish the tail with read_int.
+///
+/// @return The number of integers written to out.  input is advanced past
+///         them.
+///
+template< uint64_t ( *whitespace_mask )( const char* ) >
+[[gnu::always_inline]]
+inline size_t read_int_blocks( std::string_view& input, std::span< size_t > out )
+{
+  const char* data = input.data();
+  const size_t size = input.size();
+  size_t pos = 0;
+  size_t count = 0;
+
+  while ( count < out.size() && pos + 64 + 8 <= size ) {
+    const uint64_t ws = whitespace_mask( data + pos );
+    const uint64_t non_ws = ~ws;
+    // pos is never in the middle of a token, so there's no carry in
+    uint64_t starts = non_ws & ~( non_ws << 1 );
+    size_t consumed = 64;
+
+    while ( starts != 0 ) {
+      const unsigned start = std::countr_zero( starts );
+      const uint64_t after = ws >> start;
+      if ( after == 0 ) {
+        // Token runs into the next block.  Start the next block on it.
+        consumed = start;
+        break;
+      }
+      const unsigned length = std::countr_zero( after );
+      const char* token = data + pos + start;
+      out[ count++ ] = length <= 8
+        ? eight_digits_to_int( token, length )
+        : view_to_int( std::string_view{ token, length } );
+      if ( count == out.size() ) {
+        consumed = start + length;
+        break;
+      }
+      starts &= starts - 1;
+    }
+
+    if ( consumed == 0 ) {
+      // A token longer than a block.  Leave it for read_int.
+      break;
+    }
+    pos += consumed;
+  }
+
+  input.remove_prefix( pos );
+  return count;
+}
+
+///
+/// @brief The block loop behind count_tokens
+///
+/// @return The number of tokens that start in the blocks it covered.
+///         input is advanced past the blocks.
+///
+template< uint64_t ( *whitespace_mask )( const char* ) >
+[[gnu::always_inline]]
+inline size_t count_token_blocks( std::string_view& input )
+{
+  size_t pos = 0;
+  size_t count = 0;
+  // Whether the byte before the block was part of a token
+  uint64_t in_token = 0;
+
+  for ( ; pos + 64 <= input.size(); pos += 64 ) {
+    const uint64_t non_ws = ~whitespace_mask( input.data() + pos );
+    count += std::popcount( non_ws & ~( ( non_ws << 1 ) | in_token ) );
+    in_token = non_ws >> 63;
+  }
+
+  input.remove_prefix( pos );
+  // A token that spans the last block boundary was already counted
+  if ( in_token ) {
+    read_non_whitespace( input );
+  }
+  return count;
+}
+
+#ifdef SIMD_PARSING_X86
+[[gnu::target("avx2")]]
+inline size_t count_token_blocks_avx2( std::string_view& input )
+{
+  return count_token_blocks< whitespace_mask_avx2 >( input );
+}
+
+[[gnu::target("avx2")]]
+inline size_t read_int_blocks_avx2( std::string_view& input, std::span< size_t > out )
+{
+  return read_int_blocks< whitespace_mask_avx2 >( input, out );
+}
+
+inline bool cpu_has_avx2()
+{
+  static const bool has_avx2 = __builtin_cpu_supports( "avx2" );
+  return has_avx2;
+}
+#endif
+
+/// @brief Run time read_ints - the fastest read_int_blocks the CPU supports
+inline size_t read_int_blocks_dispatch( std::string_view& input, std::span< size_t > out )
+{
+#ifdef SIMD_PARSING_X86
+  if ( cpu_has_avx2() ) {
+    return read_int_blocks_avx2( input, out );
+  }
+  return read_int_blocks< whitespace_mask_sse2 >( input, out );
+#else
+  return read_int_blocks< whitespace_mask_scalar >( input, out );
+#endif
+}
+
+/// @brief Run time count_tokens - the fastest count_token_blocks the CPU supports
+inline size_t count_token_blocks_dispatch( std::string_view& input )
+{
+#ifdef SIMD_PARSING_X86
+  if ( cpu_has_avx2() ) {
+    return count_token_blocks_avx2( input );
+  }
+  return count_token_blocks< whitespace_mask_sse2 >( input );
+#else
+  return count_token_blocks< whitespace_mask_scalar >( input );
+#endif
+}
+
+}
+
+///
+/// @brief Read up to out.size() integers from input
+///
+/// Same result as calling read_int once per integer.  input must start at
+/// an integer (as it does after any read_int), and on return contains the
+/// remainder of the string, starting at the next integer.
+///
+/// @param input  The text we're parsing
+/// @param out    Where the integers are written
+/// @return       The number of integers read.  Less than out.size() only if
+///               input ran out.
+///
+constexpr size_t read_ints( std::string_view& input, std::span< size_t > out )
+{
+  size_t count = 0;
+
+  if ( !std::is_constant_evaluated() ) {
+    count = simd_parsing_detail::read_int_blocks_dispatch( input, out );
+    // The block loop stops just after a token; read_int starts on one
+    read_whitespace( input );
+  }
+
+  while ( count < out.size() && input.size() > 0 ) {
+    out[ count++ ] = read_int( input );
+  }
+  return count;
+}
+
+///
+/// @brief Count the whitespace separated tokens in input
+///
+/// Same result as count_words.  Vectorized at run time.
+///
+constexpr size_t count_tokens( std::string_view input )
+{
+  size_t count = 0;
+  if ( !std::is_constant_evaluated() ) {
+    count = simd_parsing_detail::count_token_blocks_dispatch( input );
+  }
+  return count + count_words( input );
+}
+
+#ifndef NO_HEADER_TESTS
+static_assert( count_tokens( "this is a test" ) == 4 );
+
+static_assert( []() {
+  std::string_view test( "42 43\n44" );
+  std::array< size_t, 2 > ints{};
+  const size_t count = read_ints( test, ints );
+  return count == 2 && ints[0] == 42 && ints[1] == 43 && test == "44";
+}() );
+#endif
+
+#endif
+
@@ -0,0 +1,55 @@
+#ifndef __SIZED_STORAGE_H__
+#define __SIZED_STORAGE_H__
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/// @brief Storage selection for containers whose size may only be known at
+///        run time.
+///
+/// Compile time graphs size their storage from the graph text, so the sizes
+/// are template parameters and the storage is a std::array.  Graphs loaded
+/// at run time use dynamic_size instead, which switches the storage to a
+/// std::vector sized when the container is constructed.
+
+/// @brief Size marker for storage that is sized at run time
+inline constexpr size_t dynamic_size = std::numeric_limits<size_t>::max();
+
+/// @brief std::array< T, max_size >, or std::vector< T > for dynamic_size
+template< typename T, size_t max_size >
+using sized_array_t = std::conditional_t<
+  max_size == dynamic_size,
+  std::vector< T >,
+  std::array< T, max_size >
+>;
+
+///
+/// @brief Create value initialized storage for at least size elements
+///
+/// @param size   The number of elements needed.  For fixed size storage this
+///               is only checked against max_size.
+/// @return       The new storage
+///
+template< typename T, size_t max_size >
+constexpr sized_array_t< T, max_size > make_sized_array( size_t size )
+{
+  if constexpr ( max_size == dynamic_size ) {
+    return sized_array_t< T, max_size >( size );
+  }
+  else {
+    if ( size > max_size ) {
+      throw std::out_of_range( "make_sized_array: size exceeds max_size" );
+    }
+    return sized_array_t< T, max_size >{};
+  }
+}
+
+static_assert( make_sized_array< int, 4 >( 3 ).size() == 4 );
+static_assert( make_sized_array< int, 4 >( 3 ).at( 2 ) == 0 );
+
+#endif
+
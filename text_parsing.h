@@ -146,10 +146,10 @@ constexpr size_t read_int_v( std::string_view input )
 
 static_assert( read_int_v( "42 43 44" ) == 42 );
 
-constexpr int count_words( std::string_view input )
+constexpr size_t count_words( std::string_view input )
 {
   bool currently_in_a_word = false;
-  int word_count = 0;
+  size_t word_count = 0;
 
   for ( auto c : input ) {
     const bool c_is_whitespace = ( c == ' ' || c == '\n' );
@@ -0,0 +1,170 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///
+/// @brief A fixed set of worker threads for data parallel loops
+///
+/// The pool is created once and reused for every parallel_for, so the
+/// rounds of a parallel graph algorithm don't pay for thread creation.
+/// The calling thread works too, so a pool of size 1 has no workers and
+/// runs everything inline.  An exception thrown on any thread is rethrown
+/// by parallel_for on the calling thread.
+///
+class thread_pool_t {
+  public:
+
+  /// @brief Create a pool that runs loops on num_threads threads
+  explicit thread_pool_t( unsigned num_threads ) {
+    num_threads = std::max( num_threads, 1u );
+    for ( unsigned worker = 1; worker < num_threads; ++worker ) {
+      workers.emplace_back( [ this ]() { worker_loop(); } );
+    }
+  }
+
+  thread_pool_t( const thread_pool_t& ) = delete;
+  thread_pool_t& operator=( const thread_pool_t& ) = delete;
+
+  ~thread_pool_t() {
+    {
+      std::lock_guard lock{ mutex };
+      stopping = true;
+    }
+    job_ready.notify_all();
+    for ( auto& worker : workers ) {
+      worker.join();
+    }
+  }
+
+  /// @brief Gets the number of threads loops run on, including the caller
+  unsigned size() const {
+    return static_cast< unsigned >( workers.size() ) + 1;
+  }
+
+  ///
+  /// @brief Call func( first, last ) on sub ranges that cover [begin, end)
+  ///
+  /// Sub ranges are handed out dynamically, so uneven work (i.e., high
+  /// degree nodes) balances out.  Returns when every sub range is done.
+  ///
+  /// @param grain  Sub range size.  0 picks one from the range size; pass 1
+  ///               when each index is already a big piece of work.
+  ///
+  template< typename F >
+  void parallel_for( size_t begin, size_t end, F func, size_t grain = 0 ) {
+    if ( begin >= end ) {
+      return;
+    }
+    if ( grain == 0 ) {
+      grain = std::max< size_t >( 1024, ( end - begin ) / ( size() * 16 ) );
+    }
+    std::atomic< size_t > next{ begin };
+
+    run( [ & ]() {
+      for ( size_t first = next.fetch_add( grain ); first < end; first = next.fetch_add( grain ) ) {
+        func( first, std::min( first + grain, end ) );
+      }
+    });
+  }
+
+  private:
+
+  /// Run job on every thread in the pool, and wait for all of them.  The
+  /// first exception any of them threw is rethrown.
+  void run( const std::function< void() >& job ) {
+    if ( workers.empty() ) {
+      job();
+      return;
+    }
+    {
+      std::lock_guard lock{ mutex };
+      current_job = &job;
+      busy_workers = workers.size();
+      job_exception = nullptr;
+      ++generation;
+    }
+    job_ready.notify_all();
+    run_job( job );
+
+    std::unique_lock lock{ mutex };
+    job_done.wait( lock, [ this ]() { return busy_workers == 0; } );
+    current_job = nullptr;
+    if ( job_exception ) {
+      std::rethrow_exception( std::exchange( job_exception, nullptr ) );
+    }
+  }
+
+  /// Run job, keeping the exception it throws for run to rethrow
+  void run_job( const std::function< void() >& job ) {
+    try {
+      job();
+    }
+    catch ( ... ) {
+      std::lock_guard lock{ mutex };
+      if ( !job_exception ) {
+        job_exception = std::current_exception();
+      }
+    }
+  }
+
+  void worker_loop() {
+    size_t seen_generation = 0;
+    while ( true ) {
+      const std::function< void() >* job = nullptr;
+      {
+        std::unique_lock lock{ mutex };
+        job_ready.wait( lock, [ & ]() { return stopping || generation != seen_generation; } );
+        if ( stopping ) {
+          return;
+        }
+        seen_generation = generation;
+        job = current_job;
+      }
+      run_job( *job );
+      {
+        std::lock_guard lock{ mutex };
+        --busy_workers;
+      }
+      job_done.notify_one();
+    }
+  }
+
+  std::vector< std::thread > workers;
+  std::mutex mutex;
+  std::condition_variable job_ready;
+  std::condition_variable job_done;
+  const std::function< void() >* current_job = nullptr;
+  std::exception_ptr job_exception;
+  size_t busy_workers = 0;
+  size_t generation = 0;
+  bool stopping = false;
+};
+
+/// @brief Gets --threads' count.  Throws std::invalid_argument unless it's
+///        a whole number of at least 1.
+inline unsigned parse_thread_count( std::string_view text )
+{
+  unsigned threads = 0;
+  const auto [ end, error ] = std::from_chars( text.data(), text.data() + text.size(), threads );
+  if ( error != std::errc{} || end != text.data() + text.size() || threads == 0 ) {
+    throw std::invalid_argument( "--threads needs a thread count of at least 1, not \"" + std::string( text ) + "\"" );
+  }
+  return threads;
+}
+
+#endif
+
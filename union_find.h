@@ -0,0 +1,204 @@
+#ifndef __UNION_FIND_H__
+#define __UNION_FIND_H__
+
+#include <string_view>
+#include <utility>
+
+#include "graph_raw.h"
+#include "connected.h"
+#include "sized_storage.h"
+#include "text_parsing.h"
+
+///
+/// @brief Disjoint set (union-find) over graph nodes
+///
+/// Union by size with path halving.  Unlike count_connected it doesn't need
+/// the reverse edges - union is symmetric - so it can consume the edge list
+/// straight from read_graph, or straight from the graph text.
+///
+/// max_nodes may be dynamic_size, in which case storage is sized when the
+/// set is constructed.
+///
+template< size_t max_nodes >
+class disjoint_set_t {
+  public:
+
+  disjoint_set_t() = delete;
+
+  /// @brief Create num_nodes sets, each containing a single node
+  ///
+  constexpr explicit disjoint_set_t( size_t num_nodes ) :
+    parent{ make_sized_array< node_int_t, max_nodes >( num_nodes ) },
+    set_size{ make_sized_array< node_int_t, max_nodes >( num_nodes ) },
+    num_sets{ num_nodes }
+  {
+    for ( size_t idx = 0; idx < num_nodes; ++idx ) {
+      parent.at( idx ) = static_cast< node_int_t >( idx );
+      set_size.at( idx ) = 1;
+    }
+  }
+
+  /// @brief Find the representative node of the set node is in
+  ///
+  /// Path halving - every other node on the path to the root is pointed
+  /// at its grandparent, so later finds are shorter.
+  ///
+  constexpr node_id_t find( node_id_t node ) {
+    size_t idx = node.value();
+    while ( parent.at( idx ) != idx ) {
+      parent.at( idx ) = parent.at( parent.at( idx ) );
+      idx = parent.at( idx );
+    }
+    return node_id_t{ idx };
+  }
+
+  /// @brief Merge the sets containing node_a and node_b
+  ///
+  /// @return true if they were in different sets before the call
+  ///
+  constexpr bool unite( node_id_t node_a, node_id_t node_b ) {
+    size_t root_a = find( node_a ).value();
+    size_t root_b = find( node_b ).value();
+    if ( root_a == root_b ) {
+      return false;
+    }
+    // Union by size - hang the smaller tree off of the larger one
+    if ( set_size.at( root_a ) < set_size.at( root_b ) ) {
+      std::swap( root_a, root_b );
+    }
+    parent.at( root_b ) = static_cast< node_int_t >( root_a );
+    set_size.at( root_a ) += set_size.at( root_b );
+    --num_sets;
+    return true;
+  }
+
+  /// @brief Gets the number of disjoint sets
+  constexpr size_t get_num_sets() const {
+    return num_sets;
+  }
+
+  private:
+
+  // Parents and set sizes are < max_nodes, so fit in a compact id integer
+  using node_int_t = compact_id_int_t< max_nodes >;
+
+  sized_array_t< node_int_t, max_nodes > parent;
+  sized_array_t< node_int_t, max_nodes > set_size;
+  size_t num_sets;
+};
+
+///
+/// @brief Count connected subgraphs of a graph using a disjoint set
+///
+/// Each edge is visited once, so there's no need for double_up_edges.  An
+/// undirected graph lists every edge at both ends, so its edges are taken
+/// from for_each_edge rather than from neighbors().
+///
+template< typename graph_type >
+constexpr int count_connected_union_find( const graph_type& graph )
+{
+  disjoint_set_t< graph_type::max_num_nodes > sets{ graph.get_num_nodes() };
+
+  if constexpr ( is_undirected_graph_v< graph_type > ) {
+    graph.for_each_edge( [&]( node_id_t src_node, node_id_t dst_node ) {
+      sets.unite( src_node, dst_node );
+    });
+  }
+  else {
+    for( size_t idx = 0; idx < graph.get_num_nodes(); ++idx ) {
+      for( const node_id_t dst_node : graph.neighbors( node_id_t{ idx } ) ) {
+        sets.unite( node_id_t{ idx }, dst_node );
+      }
+    }
+  }
+  return static_cast< int >( sets.get_num_sets() );
+}
+
+///
+/// @brief Count connected subgraphs straight from the graph text
+///
+/// Never builds a graph - edges are fed to the disjoint set as they are
+/// parsed.  max_nodes must be at least the node count in the text, or
+/// dynamic_size.
+///
+template< size_t max_nodes = dynamic_size >
+constexpr int count_connected_union_find( std::string_view text )
+{
+  const auto num_nodes = read_int( text );
+  disjoint_set_t< max_nodes > sets{ num_nodes };
+
+  for_each_text_edge( text, [&]( node_id_t src_node, node_id_t dst_node ) {
+    sets.unite( src_node, dst_node );
+  });
+  return static_cast< int >( sets.get_num_sets() );
+}
+
+///
+/// @brief A graph_raw that keeps its component count up to date
+///
+/// Every add_edge also unites the edge's nodes in an embedded disjoint set,
+/// so get_num_components() is O(1) between batches of edge inserts.  Costs
+/// two node sized arrays and a find per endpoint per edge.
+///
+template< size_t max_nodes, size_t max_edges >
+using tracked_graph_t = graph_raw< max_nodes, max_edges, disjoint_set_t< max_nodes > >;
+
+/// @brief Tracked graph type for graphs that are loaded at run time
+using runtime_tracked_graph_t = tracked_graph_t< dynamic_size, dynamic_size >;
+
+#ifndef NO_HEADER_TESTS
+// Union by size.  On a tie the first node's root stays a root; otherwise
+// the smaller set goes under the larger, whichever side it's on.  A unite
+// within one set changes nothing.
+static_assert( []() {
+  disjoint_set_t< 5 > sets{ 5 };
+  const bool merged = sets.unite( node_id_t{ 3 }, node_id_t{ 2 } )
+    && sets.unite( node_id_t{ 1 }, node_id_t{ 0 } );
+  const bool first_tie = sets.find( node_id_t{ 2 } ) == node_id_t{ 3 };
+  sets.unite( node_id_t{ 0 }, node_id_t{ 2 } );
+  const bool second_tie = sets.find( node_id_t{ 3 } ) == node_id_t{ 1 };
+  sets.unite( node_id_t{ 4 }, node_id_t{ 3 } );
+  return merged && first_tie && second_tie
+    && sets.find( node_id_t{ 4 } ) == node_id_t{ 1 }
+    && sets.find( node_id_t{ 2 } ) == node_id_t{ 1 }
+    && !sets.unite( node_id_t{ 2 }, node_id_t{ 0 } )
+    && sets.get_num_sets() == 1;
+}() );
+static_assert( count_connected_union_find< 4 >( "4 " ) == 4 );
+static_assert( count_connected_union_find(
+  read_graph< graph_raw< 4, 4 > >( "4 3 2 1 0 2 0" ) ) == 1 );
+// Agrees with count_connected on a cycle, a self loop and a repeated edge
+static_assert( []() {
+  const auto graph = read_graph< graph_raw< 9, 16 > >( "9 0 1 1 2 2 0 3 3 4 5 5 4 6 7" );
+  return count_connected_union_find( graph ) == 5 && count_connected_dfs( graph ) == 5;
+}() );
+// remove_edge rebuilds the tracker.  Neither an edge on a cycle nor one
+// copy of a repeated edge splits a component, but the last copy does.
+static_assert( []() {
+  auto graph = read_graph< tracked_graph_t< 5, 5 > >( "5 0 1 1 2 2 0 3 4 4 3" );
+  const bool before = graph.get_num_components() == 2;
+  graph.remove_edge( node_id_t{ 1 }, node_id_t{ 2 } );
+  const bool cycle = graph.get_num_components() == 2;
+  graph.remove_edge( node_id_t{ 3 }, node_id_t{ 4 } );
+  const bool repeated = graph.get_num_components() == 2;
+  graph.remove_edge( node_id_t{ 4 }, node_id_t{ 3 } );
+  return before && cycle && repeated && graph.get_num_components() == 3;
+}() );
+static_assert( []() {
+  tracked_graph_t< 4, 4 > graph{ 4 };
+  const bool before = graph.get_num_components() == 4;
+  graph.add_edge( node_id_t{ 3 }, node_id_t{ 2 } );
+  graph.add_edge( node_id_t{ 1 }, node_id_t{ 0 } );
+  const bool middle = graph.get_num_components() == 2;
+  graph.add_edge( node_id_t{ 2 }, node_id_t{ 0 } );
+  return before && middle && graph.get_num_components() == 1;
+}() );
+static_assert( []() {
+  auto graph = read_graph< tracked_graph_t< 4, 3 > >( "4 0 1 1 2 2 3" );
+  graph.remove_edge( node_id_t{ 1 }, node_id_t{ 2 } );
+  return graph.get_num_components() == 2;
+}() );
+#endif
+
+#endif
+